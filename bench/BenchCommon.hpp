@@ -0,0 +1,123 @@
+#pragma once
+#include "core/GraphEngine.hpp"
+#include "nodes/BiquadNode.hpp"
+#include "nodes/MixerNode.hpp"
+#include "nodes/OscillatorNode.hpp"
+#include "nodes/PanNode.hpp"
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @file BenchCommon.hpp
+ * @brief Helpers shared by the benchmark programs: pass/fail reporting,
+ * block timing and the voice patch most of them render.
+ */
+
+namespace bench {
+
+using Clock = std::chrono::steady_clock;
+
+/** Number of failed check() calls. */
+inline int failures = 0;
+
+/** Prints a named check with its result and counts failures. */
+inline void check(bool ok, const char *what) {
+  std::printf("  %-52s %s\n", what, ok ? "PASS" : "FAIL");
+  if (!ok) {
+    ++failures;
+  }
+}
+
+/** Renders blocks and returns the mean time per block in seconds. */
+inline double renderBlocks(ms::GraphEngine &engine, int blocks) {
+  const Clock::time_point start = Clock::now();
+  for (int i = 0; i < blocks; ++i) {
+    engine.process();
+  }
+  return std::chrono::duration<double>(Clock::now() - start).count() / blocks;
+}
+
+/**
+ * Settings of the voice patch: per voice a saw oscillator, a lowpass filter
+ * and a panner, summed into the mixers "left" and "right", which are the
+ * graph's two outputs.
+ */
+struct VoicePatch {
+  /** Number of voices. */
+  int voices = 16;
+
+  /** Oscillator frequency of a voice in Hz. */
+  std::function<float(int)> frequency = [](int v) {
+    return 55.0f * (1.0f + 0.5f * static_cast<float>(v % 12));
+  };
+
+  /** Filter cutoff of a voice in Hz. */
+  std::function<float(int)> cutoff = [](int v) {
+    return 800.0f + 100.0f * static_cast<float>(v);
+  };
+
+  /** Filter quality factor. */
+  float q = 2.0f;
+
+  /** Pans the voices from left to right instead of to the center. */
+  bool spread = false;
+
+  /** Gain of every mixer input. */
+  float mixGain = 1.0f;
+
+  /**
+   * Optional Node with an "in" and an "out" port inserted between a voice's
+   * filter and panner; may return nullptr.
+   */
+  std::function<std::shared_ptr<ms::Node>(int)> insert;
+};
+
+/** Builds the voice patch; the Nodes of voice v end in v. */
+inline ms::Graph buildVoiceGraph(const VoicePatch &patch) {
+  const int voices = patch.voices;
+  ms::Graph graph;
+  graph.addNode(std::make_shared<ms::MixerNode>("left", voices));
+  graph.addNode(std::make_shared<ms::MixerNode>("right", voices));
+  for (int v = 0; v < voices; ++v) {
+    const std::string n = std::to_string(v);
+    graph.addNode(std::make_shared<ms::OscillatorNode>(
+        "osc" + n, patch.frequency(v), ms::dsp::Waveform::Saw));
+    graph.addNode(std::make_shared<ms::BiquadNode>(
+        "filter" + n, ms::BiquadNode::Mode::Lowpass, patch.cutoff(v),
+        patch.q));
+    const float pan = patch.spread && voices > 1
+                          ? -1.0f + 2.0f * static_cast<float>(v) / (voices - 1)
+                          : 0.0f;
+    graph.addNode(std::make_shared<ms::PanNode>("pan" + n, pan));
+    graph.connect("osc" + n, "out", "filter" + n, "in");
+    std::shared_ptr<ms::Node> inserted =
+        patch.insert ? patch.insert(v) : nullptr;
+    if (inserted) {
+      graph.addNode(inserted);
+      graph.connect("filter" + n, "out", inserted->getId(), "in");
+      graph.connect(inserted->getId(), "out", "pan" + n, "in");
+    } else {
+      graph.connect("filter" + n, "out", "pan" + n, "in");
+    }
+    graph.connect("pan" + n, "left", "left", "in" + n);
+    graph.connect("pan" + n, "right", "right", "in" + n);
+  }
+  if (patch.mixGain != 1.0f) {
+    for (auto *mixer : {"left", "right"}) {
+      std::vector<ms::Param> gains = graph.getNode(mixer)->getParams();
+      for (ms::Param &gain : gains) {
+        gain.value = patch.mixGain;
+      }
+      graph.getNode(mixer)->setParams(gains);
+    }
+  }
+  graph.addOutput("left", "out");
+  graph.addOutput("right", "out");
+  return graph;
+}
+
+} // namespace bench
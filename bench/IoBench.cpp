@@ -0,0 +1,198 @@
+#include "io/AudioDevice.hpp"
+#include "io/BlockAdapter.hpp"
+#include "nodes/AudioInputNode.hpp"
+#include "nodes/MixerNode.hpp"
+#include "nodes/OscillatorNode.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @file IoBench.cpp
+ * @brief Checks and measures the device I/O layer without audio hardware.
+ *
+ * The loopback part drives a BlockAdapter with fixed and variable callback
+ * sizes through a graph that copies its physical inputs to its outputs. It
+ * verifies that every output frame equals the input frame exactly
+ * getLatencyFrames() earlier and reports the adapter's throughput. It also
+ * checks that a plan with the wrong block size is output as silence. The
+ * device part runs an AudioDevice on miniaudio's null backend, with and
+ * without a fixed callback period. Exits with status 1 if any check fails.
+ *
+ * Usage: IoBench [seconds of null device run]
+ */
+
+namespace {
+
+constexpr int kChannels = 2;
+
+ms::Graph buildLoopback() {
+  ms::Graph graph;
+  for (int c = 0; c < kChannels; ++c) {
+    const std::string id = "in" + std::to_string(c);
+    graph.addNode(std::make_shared<ms::AudioInputNode>(id, c));
+    graph.addOutput(id, "out");
+  }
+  return graph;
+}
+
+/** Feeds a ramp through the adapter; returns false on a mismatch. */
+bool runLoopback(int blockSize, int fixedCallbackFrames) {
+  constexpr int kMaxCallback = 1024;
+  constexpr int kFrames = 1 << 20;
+
+  ms::GraphEngine engine;
+  ms::CompileOptions options;
+  options.blockSize = blockSize;
+  options.numPhysicalInputs = kChannels;
+  engine.commit(buildLoopback(), options);
+  ms::BlockAdapter adapter(engine, blockSize, kChannels, kChannels,
+                           kMaxCallback, fixedCallbackFrames);
+  const int latency = adapter.getLatencyFrames();
+
+  // Frame n carries n on channel 0 and -n on channel 1, exact in float.
+  std::vector<float> input(static_cast<size_t>(kFrames) * kChannels);
+  std::vector<float> output(input.size());
+  for (int n = 0; n < kFrames; ++n) {
+    input[n * kChannels] = static_cast<float>(n);
+    input[n * kChannels + 1] = -static_cast<float>(n);
+  }
+
+  std::mt19937 random(42);
+  std::uniform_int_distribution<int> sizes(1, kMaxCallback);
+  const auto start = std::chrono::steady_clock::now();
+  int numCallbacks = 0;
+  for (int n = 0; n < kFrames;) {
+    const int frames = std::min(
+        kFrames - n,
+        fixedCallbackFrames > 0 ? fixedCallbackFrames : sizes(random));
+    adapter.process(input.data() + static_cast<size_t>(n) * kChannels,
+                    output.data() + static_cast<size_t>(n) * kChannels,
+                    frames);
+    n += frames;
+    ++numCallbacks;
+  }
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  int firstError = -1;
+  for (int n = 0; n < kFrames && firstError < 0; ++n) {
+    const float expected = n < latency ? 0.0f : static_cast<float>(n - latency);
+    if (output[n * kChannels] != expected ||
+        output[n * kChannels + 1] != -expected) {
+      firstError = n;
+    }
+  }
+  const bool ok = firstError < 0 && adapter.getNumUnderruns() == 0;
+
+  char callback[32];
+  if (fixedCallbackFrames > 0) {
+    std::snprintf(callback, sizeof(callback), "%d", fixedCallbackFrames);
+  } else {
+    std::snprintf(callback, sizeof(callback), "1..%d", kMaxCallback);
+  }
+  std::printf("%6d %10s %9d %9llu %12.1f %s", blockSize, callback, latency,
+              static_cast<unsigned long long>(adapter.getNumUnderruns()),
+              kFrames / elapsed.count() / 1e6, ok ? "PASS" : "FAIL");
+  if (firstError >= 0) {
+    std::printf(" (frame %d of %d callbacks)", firstError, numCallbacks);
+  }
+  std::printf("\n");
+  return ok;
+}
+
+/** Commits a plan with the wrong block size; expects silence, no overrun. */
+bool runMismatch() {
+  constexpr int kBlock = 256;
+  constexpr int kFrames = 1024;
+  ms::GraphEngine engine;
+  ms::CompileOptions options;
+  options.blockSize = kBlock / 2;
+  options.numPhysicalInputs = kChannels;
+  engine.commit(buildLoopback(), options);
+  ms::BlockAdapter adapter(engine, kBlock, kChannels, kChannels, kFrames);
+
+  std::vector<float> input(static_cast<size_t>(kFrames) * kChannels, 1.0f);
+  std::vector<float> output(input.size(), 1.0f);
+  adapter.process(input.data(), output.data(), kFrames);
+  bool silent = true;
+  for (float sample : output) {
+    silent = silent && sample == 0.0f;
+  }
+  const bool ok = silent && adapter.getNumUnderruns() > 0;
+  std::printf("mismatched plan block size: silent %s, underruns %llu %s\n",
+              silent ? "yes" : "no",
+              static_cast<unsigned long long>(adapter.getNumUnderruns()),
+              ok ? "PASS" : "FAIL");
+  return ok;
+}
+
+bool runNullDevice(double seconds, bool fixedPeriod) {
+  ms::Graph graph = buildLoopback();
+  graph.addNode(std::make_shared<ms::OscillatorNode>("osc", 440.0f));
+  graph.addNode(std::make_shared<ms::MixerNode>("mix", 2));
+  graph.connect("osc", "out", "mix", "in0");
+  graph.connect("in0", "out", "mix", "in1");
+  graph.clearOutputs();
+  graph.addOutput("mix", "out");
+  graph.addOutput("in1", "out");
+
+  ms::AudioDeviceOptions options;
+  options.backend = ms::AudioDeviceOptions::Backend::Null;
+  options.numInputs = kChannels;
+  options.numOutputs = kChannels;
+  options.periodFrames = 480;
+  options.fixedPeriod = fixedPeriod;
+
+  ms::AudioDevice device;
+  std::string error;
+  if (!device.open(graph, options, &error) || !device.start(&error)) {
+    std::printf("null device: FAIL (%s)\n", error.c_str());
+    return false;
+  }
+  std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+  device.stop();
+
+  const uint64_t callbacks = device.getNumCallbacks();
+  const uint64_t frames = device.getFramesProcessed();
+  // A fixed 480-frame period shares gcd(480, 256) = 32 frames with the
+  // block, so only 224 frames of latency are needed.
+  const bool fixedOk = frames == callbacks * 480 &&
+                       device.getLatencyFrames() == device.getBlockSize() - 32;
+  const bool ok = callbacks > 0 && device.getNumUnderruns() == 0 &&
+                  (!fixedPeriod || fixedOk);
+  std::printf("null device%s: %.0f Hz, block %d, %llu callbacks, "
+              "%.1f frames/callback, latency %d, underruns %llu %s\n",
+              fixedPeriod ? ", fixed period" : "", device.getSampleRate(),
+              device.getBlockSize(),
+              static_cast<unsigned long long>(callbacks),
+              callbacks ? static_cast<double>(frames) / callbacks : 0.0,
+              device.getLatencyFrames(),
+              static_cast<unsigned long long>(device.getNumUnderruns()),
+              ok ? "PASS" : "FAIL");
+  return ok;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const double seconds = argc > 1 ? std::atof(argv[1]) : 0.5;
+
+  std::printf("%6s %10s %9s %9s %12s\n", "block", "callback", "latency",
+              "underruns", "Mframes/s");
+  bool passed = true;
+  const int configs[][2] = {{256, 256}, {256, 512}, {256, 64}, {256, 480},
+                            {256, 0},   {128, 441}, {64, 0}};
+  for (const auto &config : configs) {
+    passed = runLoopback(config[0], config[1]) && passed;
+  }
+  passed = runMismatch() && passed;
+  passed = runNullDevice(seconds, false) && passed;
+  passed = runNullDevice(seconds, true) && passed;
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,121 @@
+#include "BenchCommon.hpp"
+#include "io/OfflineRenderer.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+
+/**
+ * @file OfflineRender.cpp
+ * @brief Renders a synthetic patch to a file and reports the realtime factor.
+ *
+ * The patch has one oscillator, filter and panner per voice, all summed
+ * into a stereo mixer. No audio device is used, so this runs on CI machines
+ * to track throughput over time.
+ *
+ * Usage: OfflineRender [--out file] [--seconds s] [--voices n]
+ *                      [--rate hz] [--block frames] [--threads n]
+ *                      [--format wav|raw] [--sample f32|s16|s24|s32]
+ *                      [--dither none|triangle]
+ */
+
+namespace {
+
+const char *const kUsage =
+    "usage: OfflineRender [--out file] [--seconds s] [--voices n]\n"
+    "                     [--rate hz] [--block frames] [--threads n]\n"
+    "                     [--format wav|raw] [--sample f32|s16|s24|s32]\n"
+    "                     [--dither none|triangle]\n";
+
+ms::Graph buildGraph(int voices) {
+  bench::VoicePatch patch;
+  patch.voices = voices;
+  patch.spread = true;
+  patch.mixGain = 1.0f / voices;
+  return bench::buildVoiceGraph(patch);
+}
+
+bool parseSampleFormat(const char *name,
+                       ms::OfflineRenderOptions::SampleFormat &format) {
+  using Format = ms::OfflineRenderOptions::SampleFormat;
+  const struct {
+    const char *name;
+    Format format;
+  } formats[] = {{"f32", Format::Float32},
+                 {"s16", Format::Int16},
+                 {"s24", Format::Int24},
+                 {"s32", Format::Int32}};
+  for (const auto &entry : formats) {
+    if (std::strcmp(name, entry.name) == 0) {
+      format = entry.format;
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  ms::OfflineRenderOptions options;
+  std::string path = "render.wav";
+  double seconds = 60.0;
+  int voices = 32;
+
+  for (int i = 1; i < argc; i += 2) {
+    const std::string key = argv[i];
+    if (key == "--help" || key == "-h") {
+      std::printf("%s", kUsage);
+      return 0;
+    }
+    if (i + 1 == argc) {
+      std::fprintf(stderr, "missing value for %s\n%s", key.c_str(), kUsage);
+      return 2;
+    }
+    const char *value = argv[i + 1];
+    if (key == "--out") {
+      path = value;
+    } else if (key == "--seconds") {
+      seconds = std::atof(value);
+    } else if (key == "--voices") {
+      voices = std::max(1, std::atoi(value));
+    } else if (key == "--rate") {
+      options.sampleRate = std::atof(value);
+    } else if (key == "--block") {
+      options.blockSize = std::atoi(value);
+    } else if (key == "--threads") {
+      options.numThreads = std::atoi(value);
+    } else if (key == "--format" && std::strcmp(value, "wav") == 0) {
+      options.fileFormat = ms::OfflineRenderOptions::FileFormat::Wav;
+    } else if (key == "--format" && std::strcmp(value, "raw") == 0) {
+      options.fileFormat = ms::OfflineRenderOptions::FileFormat::Raw;
+    } else if (key == "--sample" &&
+               parseSampleFormat(value, options.sampleFormat)) {
+    } else if (key == "--dither" && std::strcmp(value, "none") == 0) {
+      options.dither = ms::OfflineRenderOptions::Dither::None;
+    } else if (key == "--dither" && std::strcmp(value, "triangle") == 0) {
+      options.dither = ms::OfflineRenderOptions::Dither::Triangle;
+    } else {
+      std::fprintf(stderr, "unknown option %s %s\n%s", key.c_str(), value,
+                   kUsage);
+      return 2;
+    }
+  }
+
+  ms::OfflineRenderStats stats;
+  std::string error;
+  if (!ms::renderToFile(buildGraph(voices), path, seconds, options, &stats,
+                        &error)) {
+    std::fprintf(stderr, "render failed: %s\n", error.c_str());
+    return 1;
+  }
+  std::printf("%s: %.1f s of audio, %d voices, %.0f Hz, block %d, "
+              "%d thread(s)\n",
+              path.c_str(), stats.audioSeconds, voices, options.sampleRate,
+              options.blockSize, options.numThreads);
+  std::printf("process %.3f s, total %.3f s, realtime factor %.1fx\n",
+              stats.processSeconds, stats.totalSeconds,
+              stats.getRealtimeFactor());
+  return 0;
+}
@@ -0,0 +1,176 @@
+#include "BenchCommon.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @file ParallelBench.cpp
+ * @brief Measures how graph rendering scales from 1 to N threads.
+ *
+ * Builds synthetic graphs of independent branches feeding one summing sink
+ * and renders them with an increasing number of threads. Every thread count
+ * must reproduce the single-threaded output bit for bit; the process exits
+ * nonzero otherwise. Build in Release for meaningful numbers.
+ *
+ * Usage: ParallelBench [branches] [depth] [blocks]
+ */
+
+namespace {
+
+/** Generates a sine wave; the root of every branch. */
+class SineNode : public ms::Node {
+public:
+  SineNode(const std::string &id, float frequency)
+      : ms::Node(id), frequency_(frequency) {
+    addOutputPort("out", ms::PortType::Audio);
+  }
+
+  void process(const ms::ProcessContext &ctx) override {
+    const float increment =
+        frequency_ / static_cast<float>(getSampleRate()) * 6.2831853f;
+    for (int i = 0; i < ctx.numFrames; ++i) {
+      ctx.outputs[0][i] = std::sin(phase_);
+      phase_ += increment;
+      if (phase_ > 6.2831853f) {
+        phase_ -= 6.2831853f;
+      }
+    }
+  }
+
+private:
+  float frequency_;
+  float phase_ = 0.0f;
+};
+
+/** A waveshaper with a configurable amount of work per sample. */
+class ShaperNode : public ms::Node {
+public:
+  ShaperNode(const std::string &id, int iterations)
+      : ms::Node(id), iterations_(iterations) {
+    addInputPort("in", ms::PortType::Audio);
+    addOutputPort("out", ms::PortType::Audio, 0);
+  }
+
+  void process(const ms::ProcessContext &ctx) override {
+    for (int i = 0; i < ctx.numFrames; ++i) {
+      float x = ctx.inputs[0][i];
+      for (int k = 0; k < iterations_; ++k) {
+        x = std::tanh(1.5f * x);
+      }
+      ctx.outputs[0][i] = x;
+    }
+  }
+
+private:
+  int iterations_;
+};
+
+/** Sums all of its inputs. */
+class SumNode : public ms::Node {
+public:
+  SumNode(const std::string &id, int numInputs) : ms::Node(id) {
+    for (int i = 0; i < numInputs; ++i) {
+      addInputPort("in" + std::to_string(i), ms::PortType::Audio);
+    }
+    addOutputPort("out", ms::PortType::Audio);
+  }
+
+  void process(const ms::ProcessContext &ctx) override {
+    std::fill(ctx.outputs[0], ctx.outputs[0] + ctx.numFrames, 0.0f);
+    for (size_t p = 0; p < getInputPorts().size(); ++p) {
+      for (int i = 0; i < ctx.numFrames; ++i) {
+        ctx.outputs[0][i] += ctx.inputs[p][i];
+      }
+    }
+  }
+};
+
+ms::Graph buildGraph(int branches, int depth) {
+  ms::Graph graph;
+  graph.addNode(std::make_shared<SumNode>("sum", branches));
+  for (int b = 0; b < branches; ++b) {
+    std::string previous = "osc" + std::to_string(b);
+    graph.addNode(std::make_shared<SineNode>(previous, 110.0f + b));
+    for (int d = 0; d < depth; ++d) {
+      const std::string id =
+          "fx" + std::to_string(b) + "_" + std::to_string(d);
+      graph.addNode(std::make_shared<ShaperNode>(id, 4));
+      graph.connect(previous, "out", id, "in");
+      previous = id;
+    }
+    graph.connect(previous, "out", "sum", "in" + std::to_string(b));
+  }
+  graph.addOutput("sum", "out");
+  return graph;
+}
+
+/** Renders blocks from a fresh graph and returns the first output channel. */
+std::vector<float> renderOutput(ms::GraphEngine &engine, int blocks) {
+  std::vector<float> output;
+  for (int i = 0; i < blocks; ++i) {
+    engine.process();
+    const ms::ExecutionPlan *plan = engine.getCurrentPlan();
+    const float *block = plan->getOutputBuffer(0);
+    output.insert(output.end(), block, block + plan->getBlockSize());
+  }
+  return output;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const int branches = argc > 1 ? std::atoi(argv[1]) : 64;
+  const int depth = argc > 2 ? std::atoi(argv[2]) : 4;
+  const int blocks = argc > 3 ? std::atoi(argv[3]) : 2000;
+  // At least two threads so the bit-exactness check covers the parallel path.
+  const int maxThreads =
+      static_cast<int>(std::max(2u, std::thread::hardware_concurrency()));
+
+  std::printf("graph: %d branches x %d nodes + sink, %d blocks of 256\n",
+              branches, depth + 1, blocks);
+  std::printf("%8s %14s %10s %10s\n", "threads", "us/block", "speedup",
+              "xRT");
+
+  constexpr int kCheckedBlocks = 64;
+  std::vector<float> reference;
+  bool identical = true;
+  double serialTime = 0.0;
+  for (int threads = 1; threads <= maxThreads; ++threads) {
+    ms::CompileOptions options;
+    options.numThreads = threads;
+    options.parallelThreshold = 0;
+    ms::GraphEngine engine;
+    // A fresh graph per run so every engine starts from the same node state.
+    engine.commit(buildGraph(branches, depth), options);
+    // The first blocks pick up the plan and warm the caches.
+    const std::vector<float> output = renderOutput(engine, kCheckedBlocks);
+    if (threads == 1) {
+      reference = output;
+    } else {
+      identical = identical && output.size() == reference.size() &&
+                  std::memcmp(output.data(), reference.data(),
+                              output.size() * sizeof(float)) == 0;
+    }
+
+    const double perBlock = bench::renderBlocks(engine, blocks);
+    if (threads == 1) {
+      serialTime = perBlock;
+    }
+    const double blockDuration = options.blockSize / options.sampleRate;
+    std::printf("%8d %14.2f %10.2f %10.1f\n", threads, perBlock * 1e6,
+                serialTime / perBlock, blockDuration / perBlock);
+    if (threads == 1 || threads == maxThreads) {
+      const ms::BufferStats &stats = engine.getCurrentPlan()->getBufferStats();
+      std::printf("%8s %zu audio outputs in %zu buffers (%zu bytes)\n", "",
+                  stats.numAudioOutputs, stats.peakBuffers, stats.bytes);
+    }
+  }
+  bench::check(identical, "N threads match 1 thread bit for bit");
+  return bench::failures == 0 ? 0 : 1;
+}
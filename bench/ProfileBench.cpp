@@ -0,0 +1,219 @@
+#include "BenchCommon.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @file ProfileBench.cpp
+ * @brief Measures the cost of the profiler and checks what it reports.
+ *
+ * First renders a voice patch with and without Node timing, in interleaved
+ * rounds, and prints the median overhead per Node. Then adds a Node that
+ * overruns the block period every few blocks and checks that the profiler
+ * counts those xruns and blames that Node for them. Exits with a non-zero
+ * status if a check fails.
+ *
+ * Usage: ProfileBench [--voices n] [--blocks n] [--threads n] [--trace file]
+ */
+
+namespace {
+
+const char *const kUsage = "usage: ProfileBench [--voices n] [--blocks n] "
+                           "[--threads n] [--trace file]\n";
+
+using bench::check;
+using bench::Clock;
+using bench::renderBlocks;
+
+/** Passes audio through, spinning past the block period every few blocks. */
+class SpikeNode : public ms::Node {
+public:
+  SpikeNode(const std::string &id, int interval)
+      : ms::Node(id), interval_(interval) {
+    addInputPort("in", ms::PortType::Audio);
+    addOutputPort("out", ms::PortType::Audio, 0);
+  }
+
+  void process(const ms::ProcessContext &ctx) override {
+    if (++blocks_ % interval_ != 0) {
+      return;
+    }
+    const std::chrono::duration<double> period(ctx.numFrames /
+                                               getSampleRate());
+    const Clock::time_point end =
+        Clock::now() +
+        std::chrono::duration_cast<Clock::duration>(period * 1.5);
+    while (Clock::now() < end) {
+    }
+  }
+
+private:
+  int interval_;
+  int blocks_ = 0;
+};
+
+ms::Graph buildGraph(int voices, int spikeInterval) {
+  bench::VoicePatch patch;
+  patch.voices = voices;
+  patch.insert = [spikeInterval](int v) -> std::shared_ptr<ms::Node> {
+    if (v != 0 || spikeInterval <= 0) {
+      return nullptr;
+    }
+    return std::make_shared<SpikeNode>("spike", spikeInterval);
+  };
+  return bench::buildVoiceGraph(patch);
+}
+
+/** Returns the median of the values, reordering them. */
+double median(std::vector<double> &values) {
+  const auto middle = values.begin() + values.size() / 2;
+  std::nth_element(values.begin(), middle, values.end());
+  return *middle;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int voices = 16;
+  int blocks = 2000;
+  int threads = 1;
+  const char *tracePath = nullptr;
+  for (int i = 1; i < argc; i += 2) {
+    if (i + 1 == argc) {
+      std::fprintf(stderr, "missing value for %s\n%s", argv[i], kUsage);
+      return 2;
+    }
+    if (std::strcmp(argv[i], "--voices") == 0) {
+      voices = std::max(1, std::atoi(argv[i + 1]));
+    } else if (std::strcmp(argv[i], "--blocks") == 0) {
+      blocks = std::max(100, std::atoi(argv[i + 1]));
+    } else if (std::strcmp(argv[i], "--threads") == 0) {
+      threads = std::max(1, std::atoi(argv[i + 1]));
+    } else if (std::strcmp(argv[i], "--trace") == 0) {
+      tracePath = argv[i + 1];
+    } else {
+      std::fprintf(stderr, "unknown option %s\n%s", argv[i], kUsage);
+      return 2;
+    }
+  }
+  if (!ms::Profiler::isCompiledIn()) {
+    std::printf("profiling is compiled out (MS_ENABLE_PROFILING=OFF)\n");
+    return 0;
+  }
+
+  ms::CompileOptions options;
+  options.numThreads = threads;
+  options.parallelThreshold = 0;
+  const size_t numNodes = static_cast<size_t>(voices) * 3 + 2;
+
+  // Overhead: two engines render the same patch, one with Node timing. Short
+  // rounds alternate between them, swapping which goes first, and the median
+  // of the per-round differences is reported, so frequency changes and other
+  // noise that spans a few rounds cancel out.
+  {
+    ms::GraphEngine untimed;
+    ms::GraphEngine timed;
+    untimed.commit(buildGraph(voices, 0), options);
+    timed.commit(buildGraph(voices, 0), options);
+    timed.getProfiler().start();
+    renderBlocks(untimed, blocks / 4);
+    renderBlocks(timed, blocks / 4);
+    const int rounds = 41;
+    const int roundBlocks = std::max(10, blocks / 20);
+    std::vector<double> off(rounds);
+    std::vector<double> on(rounds);
+    std::vector<double> diff(rounds);
+    for (int round = 0; round < rounds; ++round) {
+      if (round % 2 == 0) {
+        off[round] = renderBlocks(untimed, roundBlocks);
+        on[round] = renderBlocks(timed, roundBlocks);
+      } else {
+        on[round] = renderBlocks(timed, roundBlocks);
+        off[round] = renderBlocks(untimed, roundBlocks);
+      }
+      diff[round] = on[round] - off[round];
+    }
+    timed.getProfiler().stop();
+    const double offMedian = median(off);
+    const double onMedian = median(on);
+    const double perNode = median(diff) / numNodes;
+    std::printf("%zu nodes, %d thread(s), clock %.3f GHz\n", numNodes, threads,
+                ms::Profiler::getTicksPerSecond() * 1e-9);
+    std::printf("  block: %.2f us untimed, %.2f us timed (medians of %d "
+                "rounds), %+.1f ns per node\n",
+                offMedian * 1e6, onMedian * 1e6, rounds, perNode * 1e9);
+    check(perNode >= 0.0, "timing Nodes does not make blocks faster");
+  }
+
+  // Attribution: a Node that overruns every 50th block. Rendering runs
+  // faster than real time, so the rings are drained more often than usual.
+  const int spikeInterval = 50;
+  ms::ProfilerOptions profilerOptions;
+  profilerOptions.collectIntervalMs = 1;
+  ms::GraphEngine engine;
+  ms::Profiler &profiler = engine.getProfiler();
+  engine.commit(buildGraph(voices, spikeInterval), options);
+  engine.process();
+  profilerOptions.maxTraceEvents = tracePath ? 1u << 20 : 0;
+  profiler.reset();
+  profiler.start(profilerOptions);
+  renderBlocks(engine, blocks);
+  profiler.stop();
+
+  const ms::BlockStats stats = profiler.getBlockStats();
+  std::printf("%d blocks with a spike every %d\n", blocks, spikeInterval);
+  std::printf("  load avg %.1f%%  p50 %.0f%%  p90 %.0f%%  p99 %.0f%%  "
+              "p99.9 %.0f%%  worst %.1f%% (%.2f ms)\n",
+              stats.averageLoad * 100, stats.p50Load * 100,
+              stats.p90Load * 100, stats.p99Load * 100, stats.p999Load * 100,
+              stats.worstLoad * 100, stats.worstBlockSeconds * 1e3);
+  std::printf("  xruns %llu, dropped timings %llu\n",
+              static_cast<unsigned long long>(stats.numXruns),
+              static_cast<unsigned long long>(profiler.getNumDropped()));
+
+  const std::vector<ms::NodeProfile> profiles = profiler.getNodeProfiles();
+  std::printf("  %-10s %8s %10s %10s %6s\n", "node", "calls", "avg us",
+              "max us", "xruns");
+  for (size_t i = 0; i < std::min<size_t>(5, profiles.size()); ++i) {
+    const ms::NodeProfile &p = profiles[i];
+    std::printf("  %-10s %8llu %10.2f %10.2f %6llu\n", p.id.c_str(),
+                static_cast<unsigned long long>(p.numCalls),
+                p.getAverageSeconds() * 1e6, p.maxSeconds * 1e6,
+                static_cast<unsigned long long>(p.numXrunsCaused));
+  }
+
+  // The warm-up block before reset() is not counted; the blocks rendered
+  // while collecting are.
+  const uint64_t spikes = static_cast<uint64_t>((blocks + 1) / spikeInterval);
+  uint64_t calls = 0;
+  for (const ms::NodeProfile &p : profiles) {
+    calls += p.numCalls;
+  }
+  check(stats.numBlocks == static_cast<uint64_t>(blocks),
+        "every block is counted");
+  check(stats.numXruns >= spikes, "every spike is an xrun");
+  check(stats.p50Load < 1.0 && stats.worstLoad > 1.0,
+        "percentiles separate spikes from the rest");
+  check(calls + profiler.getNumDropped() ==
+            static_cast<uint64_t>(blocks) * (numNodes + 1),
+        "every process call is timed or counted dropped");
+  check(!profiles.empty() && profiles.front().id == "spike" &&
+            (profiler.getNumDropped() > 0 ||
+             profiles.front().numXrunsCaused >= spikes),
+        "the spiking node is blamed for the xruns");
+
+  if (tracePath) {
+    std::string error;
+    const bool written = profiler.writeChromeTrace(tracePath, &error);
+    if (!written) {
+      std::fprintf(stderr, "%s\n", error.c_str());
+    }
+    check(written, "trace written");
+  }
+  return bench::failures == 0 ? 0 : 1;
+}
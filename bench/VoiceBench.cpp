@@ -0,0 +1,213 @@
+#include "BenchCommon.hpp"
+#include "core/VoicePool.hpp"
+#include "nodes/GainNode.hpp"
+#include "nodes/PolySynthNode.hpp"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <variant>
+
+/**
+ * @file VoiceBench.cpp
+ * @brief Compares the SoA voice engine with one Node chain per voice.
+ *
+ * At 16, 64 and 256 voices the same kind of patch is rendered twice: by a
+ * PolySynthNode, and by a graph with an oscillator, filter, gain and panner
+ * Node per voice summed into two mixers. Also checks voice allocation and
+ * stealing; exits with a non-zero status if a check fails. Build in
+ * Release for meaningful numbers.
+ *
+ * Usage: VoiceBench [blocks]
+ */
+
+namespace {
+
+using bench::check;
+using bench::renderBlocks;
+
+ms::RtEvent noteEvent(const ms::Node &node, ms::EventTypeId type, int note,
+                      float velocity) {
+  ms::RtEvent event;
+  event.type = type;
+  event.target = node.getHandle();
+  event.value.kind = ms::RtValue::Kind::Int;
+  event.value.i = note;
+  event.data = velocity;
+  return event;
+}
+
+int noteOfVoice(int v) { return 36 + v % 60; }
+
+/** The naive patch: one Node chain per voice, a gain as its envelope. */
+ms::Graph buildNodeGraph(int voices) {
+  bench::VoicePatch patch;
+  patch.voices = voices;
+  patch.frequency = [](int v) {
+    return 440.0f * std::exp2((noteOfVoice(v) - 69) / 12.0f);
+  };
+  patch.cutoff = [](int) { return 2000.0f; };
+  patch.q = 0.7071f;
+  patch.insert = [](int v) -> std::shared_ptr<ms::Node> {
+    return std::make_shared<ms::GainNode>("env" + std::to_string(v), 0.7f);
+  };
+  return bench::buildVoiceGraph(patch);
+}
+
+/** Returns the RMS of the last block of an output, or NaN if not finite. */
+double outputRms(const ms::GraphEngine &engine, int channel) {
+  const ms::ExecutionPlan *plan = engine.getCurrentPlan();
+  const float *out = plan->getOutputBuffer(channel);
+  double sum = 0.0;
+  for (int i = 0; i < plan->getBlockSize(); ++i) {
+    if (!std::isfinite(out[i])) {
+      return std::nan("");
+    }
+    sum += static_cast<double>(out[i]) * out[i];
+  }
+  return std::sqrt(sum / plan->getBlockSize());
+}
+
+void checkVoicePool() {
+  using Stealing = ms::VoicePool::Stealing;
+  std::printf("voice pool\n");
+  {
+    ms::VoicePool pool(4);
+    const int a = pool.noteOn(60);
+    const int b = pool.noteOn(61);
+    const int c = pool.noteOn(62);
+    pool.noteOff(61);
+    pool.free(b);
+    check(a == 0 && b == 1 && c == 2 && pool.noteOn(63) == 1,
+          "lowest free voice first, so voices stay packed");
+  }
+  {
+    ms::VoicePool pool(2, Stealing::Oldest);
+    pool.noteOn(60);
+    pool.noteOn(61);
+    check(pool.noteOn(62) == 0 && pool.getNumStolen() == 1,
+          "oldest held voice is stolen");
+  }
+  {
+    ms::VoicePool pool(2, Stealing::Oldest);
+    pool.noteOn(60);
+    pool.noteOn(61);
+    pool.noteOff(61);
+    check(pool.noteOn(62) == 1, "released voices are stolen first");
+  }
+  {
+    ms::VoicePool pool(3, Stealing::Quietest);
+    const float levels[] = {0.5f, 0.1f, 0.9f};
+    pool.noteOn(60);
+    pool.noteOn(61);
+    pool.noteOn(62);
+    check(pool.noteOn(63, levels) == 1, "quietest voice is stolen");
+  }
+  {
+    ms::VoicePool pool(1, Stealing::None);
+    pool.noteOn(60);
+    check(pool.noteOn(61) == -1 && pool.getNote(0) == 60,
+          "no stealing drops the new note");
+  }
+  {
+    ms::VoicePool pool(2);
+    pool.noteOn(60);
+    pool.noteOn(60);
+    check(pool.noteOff(60) == 0 && pool.noteOff(60) == 1 &&
+              pool.noteOff(60) == -1,
+          "repeated notes release oldest first");
+  }
+}
+
+void checkSynth() {
+  std::printf("poly synth\n");
+  ms::Graph graph;
+  auto synth = std::make_shared<ms::PolySynthNode>("synth", 8);
+  graph.addNode(synth);
+  graph.addOutput("synth", "left");
+  graph.addOutput("synth", "right");
+  std::vector<ms::Param> params = synth->getParams();
+  params[ms::PolySynthNode::kRelease].value = 0.05f;
+  synth->setParams(params);
+  ms::GraphEngine engine;
+  engine.commit(graph, ms::CompileOptions());
+  check(!synth->setParams(params) && !synth->setParam("release", 0.1f),
+        "a committed Node refuses direct parameter changes");
+  engine.sendParam(*synth, "release", 0.1f, 0, -1.0f);
+  renderBlocks(engine, 1);
+  const ms::ControlValue *release = synth->getParam("release");
+  check(release && std::get<float>(*release) == 0.1f,
+        "getParam() reports a value sent to the engine");
+
+  for (int i = 0; i < 12; ++i) {
+    engine.sendEvent(noteEvent(*synth, ms::EventTypes::NoteOn, 48 + i, 1.0f));
+  }
+  renderBlocks(engine, 10);
+  const ms::VoicePool &pool = synth->getVoicePool();
+  check(pool.getNumActive() == 8 && pool.getNumStolen() == 4,
+        "12 notes on 8 voices steal 4");
+  const double rms = outputRms(engine, 0);
+  check(rms > 1e-3 && std::isfinite(rms), "voices are audible");
+
+  for (int i = 0; i < 12; ++i) {
+    engine.sendEvent(noteEvent(*synth, ms::EventTypes::NoteOff, 48 + i, 0.0f));
+  }
+  renderBlocks(engine, 100);
+  check(pool.getNumActive() == 0 && outputRms(engine, 0) == 0.0,
+        "released voices fade out and are freed");
+
+  engine.sendEvent(noteEvent(*synth, ms::EventTypes::NoteOn, 60, 1.0f));
+  renderBlocks(engine, 10);
+  engine.sendEvent(noteEvent(*synth, ms::EventTypes::NoteOn, 60, 0.0f));
+  renderBlocks(engine, 100);
+  check(pool.getNumActive() == 0, "a note_on with velocity 0 releases");
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const int blocks = argc > 1 ? std::max(10, std::atoi(argv[1])) : 500;
+  checkVoicePool();
+  checkSynth();
+
+  const ms::CompileOptions options;
+  std::printf("%d blocks of %d, %s kernels\n", blocks, options.blockSize,
+              ms::dsp::simdLevelName(ms::dsp::kernels().level));
+  std::printf("%7s %9s %14s %14s %14s %9s\n", "voices", "nodes",
+              "nodes us/blk", "synth us/blk", "synth ns/v/f", "speedup");
+  for (int voices : {16, 64, 256}) {
+    ms::GraphEngine nodeEngine;
+    nodeEngine.commit(buildNodeGraph(voices), options);
+    renderBlocks(nodeEngine, 10);
+    const double nodeTime = renderBlocks(nodeEngine, blocks);
+
+    ms::Graph graph;
+    auto synth = std::make_shared<ms::PolySynthNode>("synth", voices);
+    graph.addNode(synth);
+    graph.addOutput("synth", "left");
+    graph.addOutput("synth", "right");
+    ms::GraphEngine synthEngine;
+    synthEngine.commit(graph, options);
+    for (int v = 0; v < voices; ++v) {
+      synthEngine.sendEvent(
+          noteEvent(*synth, ms::EventTypes::NoteOn, noteOfVoice(v), 0.8f));
+    }
+    renderBlocks(synthEngine, 10);
+    const double synthTime = renderBlocks(synthEngine, blocks);
+
+    std::printf("%7d %9zu %14.1f %14.1f %14.2f %8.2fx\n", voices,
+                nodeEngine.getCurrentPlan()->getNodes().size(), nodeTime * 1e6,
+                synthTime * 1e6,
+                synthTime * 1e9 / (static_cast<double>(voices) *
+                                   options.blockSize),
+                nodeTime / synthTime);
+    const double rms = outputRms(synthEngine, 0);
+    const std::string what =
+        std::to_string(voices) + " voices active and audible";
+    check(synth->getVoicePool().getNumActive() == voices && rms > 1e-3 &&
+              std::isfinite(rms),
+          what.c_str());
+  }
+  return bench::failures == 0 ? 0 : 1;
+}
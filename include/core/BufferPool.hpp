@@ -0,0 +1,90 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <new>
+
+/**
+ * @file BufferPool.hpp
+ * @brief Defines the arena backing the audio buffers of a compiled graph.
+ */
+
+namespace ms {
+
+/**
+ * @brief One contiguous, cache-line aligned allocation of audio buffers.
+ *
+ * Every buffer holds one block of samples and starts on a 64-byte boundary,
+ * so SIMD kernels can use aligned loads and no two buffers share a cache
+ * line. The arena is allocated and zeroed once, when a graph is compiled;
+ * which port uses which buffer is decided by ExecutionPlan::compile().
+ */
+class BufferPool {
+public:
+  /** Alignment of every buffer in bytes. */
+  static constexpr size_t kAlignment = 64;
+
+  /**
+   * @brief Allocates a zeroed arena.
+   * @param numBuffers The number of buffers.
+   * @param blockSize The number of samples per buffer.
+   */
+  BufferPool(size_t numBuffers, int blockSize)
+      : numBuffers_(numBuffers), stride_(roundUp(blockSize)) {
+    const size_t count = numBuffers_ * stride_;
+    data_.reset(static_cast<float *>(::operator new(
+        count * sizeof(float), std::align_val_t(kAlignment))));
+    for (size_t i = 0; i < count; ++i) {
+      data_[i] = 0.0f;
+    }
+  }
+
+  /**
+   * @brief Returns a buffer of the arena.
+   * @param index The buffer index, less than getNumBuffers().
+   * @return Pointer to the first sample, aligned to kAlignment.
+   */
+  float *getBuffer(size_t index) const { return data_.get() + index * stride_; }
+
+  /**
+   * @brief Returns the number of buffers in the arena.
+   * @return The number of buffers.
+   */
+  size_t getNumBuffers() const { return numBuffers_; }
+
+  /**
+   * @brief Returns the distance between two buffers.
+   * @return The stride in samples, a multiple of kAlignment / sizeof(float).
+   */
+  size_t getStride() const { return stride_; }
+
+  /**
+   * @brief Returns the size of the arena.
+   * @return The size in bytes.
+   */
+  size_t getBytes() const { return numBuffers_ * stride_ * sizeof(float); }
+
+private:
+  /** Frees memory obtained from the aligned operator new. */
+  struct AlignedDelete {
+    void operator()(float *p) const {
+      ::operator delete(p, std::align_val_t(kAlignment));
+    }
+  };
+
+  /** Rounds a sample count up to a whole number of cache lines. */
+  static size_t roundUp(int samples) {
+    const size_t perLine = kAlignment / sizeof(float);
+    return (static_cast<size_t>(samples) + perLine - 1) / perLine * perLine;
+  }
+
+  /** The number of buffers. */
+  size_t numBuffers_;
+
+  /** Distance between two buffers in samples. */
+  size_t stride_;
+
+  /** The arena. */
+  std::unique_ptr<float[], AlignedDelete> data_;
+};
+
+} // namespace ms
@@ -0,0 +1,382 @@
+#pragma once
+#include "BufferPool.hpp"
+#include "Graph.hpp"
+#include "Profiler.hpp"
+#include "WorkStealingDeque.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @file ExecutionPlan.hpp
+ * @brief Defines the compiled, real-time safe form of a Graph.
+ *
+ * Compiling validates the graph, sorts its Nodes topologically and assigns
+ * every Audio port a buffer from a single preallocated BufferPool. Running a
+ * plan is then a walk over a flat array of process calls: no hashing, no
+ * string lookups and no allocation.
+ */
+
+namespace ms {
+
+class WorkerPool;
+
+/**
+ * @brief Stream format and options used when compiling a Graph.
+ */
+struct CompileOptions {
+  /** The sample rate in Hz. */
+  double sampleRate = 48000.0;
+
+  /** The number of frames processed per block. */
+  int blockSize = 256;
+
+  /**
+   * Number of threads that render the plan, including the audio thread.
+   * 1 selects the serial path.
+   */
+  int numThreads = 1;
+
+  /**
+   * Minimum number of Nodes for which the parallel path is used. Smaller
+   * graphs are cheaper to render serially than to distribute.
+   */
+  int parallelThreshold = 32;
+
+  /**
+   * Maximum number of events delivered per block. Further events stay in
+   * their queues until the next block.
+   */
+  int maxEventsPerBlock = 1024;
+
+  /**
+   * Number of device input channels Nodes can read through
+   * Node::getPhysicalInput().
+   */
+  int numPhysicalInputs = 0;
+};
+
+/**
+ * @brief Summary of the buffer assignment of a compiled plan.
+ */
+struct BufferStats {
+  /** Number of Audio output ports in the plan. */
+  size_t numAudioOutputs = 0;
+
+  /** Peak number of buffers in use at once, excluding the silent buffer. */
+  size_t peakBuffers = 0;
+
+  /** Number of Audio outputs that overwrite their input buffer. */
+  size_t numInPlace = 0;
+
+  /** Size of the buffer arena in bytes. */
+  size_t bytes = 0;
+};
+
+/**
+ * @brief Immutable execution schedule produced from a Graph.
+ *
+ * A plan owns the buffers of its ports and keeps its Nodes alive. Once built
+ * only its scheduling counters change, so it can be handed to the audio
+ * thread as a whole and replaced atomically by GraphEngine.
+ *
+ * Buffers are assigned like registers: a buffer returns to a free list once
+ * the last reader of the signal it holds has run and is then reused by a
+ * later output, so the arena grows with the width of the graph rather than
+ * with its number of ports. In a parallel plan a buffer is only reused by a
+ * Node that is guaranteed to run after every previous user of the buffer.
+ *
+ * Nodes are grouped into tasks: maximal chains in which every Node has a
+ * single predecessor that has a single successor. Tasks are the unit of work
+ * of the parallel path; the serial path runs the same steps in task order.
+ */
+class ExecutionPlan {
+public:
+  /**
+   * @brief Compiles a Graph into an ExecutionPlan.
+   *
+   * Prepares every Node with the requested format. Nodes that another plan
+   * still holds keep their state and must already have that format. Must be
+   * called off the audio thread.
+   *
+   * @param graph The graph to compile.
+   * @param options The stream format.
+   * @param error If not null, receives a description of the failure.
+   * @return The compiled plan, or nullptr if the graph contains a cycle, the
+   * options are invalid, or a Node held by another plan would have to change
+   * format.
+   */
+  static std::unique_ptr<ExecutionPlan> compile(const Graph &graph,
+                                                const CompileOptions &options,
+                                                std::string *error = nullptr);
+
+  /**
+   * @brief Releases the Nodes, letting them be prepared at another format.
+   */
+  ~ExecutionPlan();
+
+  /**
+   * @brief Processes one block by calling every Node in topological order.
+   *
+   * Events posted since the previous block are delivered first. Real-time
+   * safe.
+   *
+   * @param profiler If not null, times every Node of the block.
+   */
+  void process(Profiler *profiler = nullptr);
+
+  /**
+   * @brief Processes one block, distributing tasks over a WorkerPool.
+   *
+   * Falls back to the serial process() when the plan was compiled for one
+   * thread, has no independent branches or is below the parallel threshold.
+   * Real-time safe.
+   *
+   * @param pool The pool providing the worker threads.
+   * @param profiler If not null, times every Node of the block on the
+   * thread that runs it.
+   */
+  void process(WorkerPool &pool, Profiler *profiler = nullptr);
+
+  /**
+   * @brief Returns true if another event fits into the next block.
+   * @return False once CompileOptions::maxEventsPerBlock events are posted.
+   */
+  bool canPostEvent() const { return numIncoming_ < incoming_.size(); }
+
+  /**
+   * @brief Queues an event for the next processed block. Real-time safe.
+   *
+   * Events addressed to a Node that is not part of the plan are dropped.
+   * Offsets outside the block are clamped to it.
+   *
+   * @param event The event to deliver.
+   * @return False if the event did not fit; see canPostEvent().
+   */
+  bool postEvent(const RtEvent &event);
+
+  /**
+   * @brief Returns true if process(WorkerPool &) renders in parallel.
+   * @return True if the parallel path is used.
+   */
+  bool isParallel() const { return parallel_; }
+
+  /**
+   * @brief Returns the number of threads the plan was compiled for.
+   * @return The number of threads, including the audio thread.
+   */
+  int getNumThreads() const { return numThreads_; }
+
+  /**
+   * @brief Returns the number of tasks the Nodes were grouped into.
+   * @return The number of tasks.
+   */
+  size_t getNumTasks() const { return tasks_.size(); }
+
+  /**
+   * @brief Returns the sample rate the plan was compiled for.
+   * @return The sample rate in Hz.
+   */
+  double getSampleRate() const { return sampleRate_; }
+
+  /**
+   * @brief Returns the block size the plan was compiled for.
+   * @return The block size in frames.
+   */
+  int getBlockSize() const { return blockSize_; }
+
+  /**
+   * @brief Returns the Nodes in execution order.
+   * @return A const reference to the vector of Nodes.
+   */
+  const std::vector<std::shared_ptr<Node>> &getNodes() const { return nodes_; }
+
+  /**
+   * @brief Finds the execution slot of a Node. Not real-time safe.
+   * @param id The identifier of the Node.
+   * @return The index of the Node in getNodes(), or -1 if not found.
+   */
+  int findNode(const std::string &id) const;
+
+  /**
+   * @brief Returns how many buffers the plan needs and how they are shared.
+   * @return The buffer statistics of the plan.
+   */
+  const BufferStats &getBufferStats() const { return bufferStats_; }
+
+  /**
+   * @brief Returns the number of graph output channels.
+   * @return The number of channels.
+   */
+  int getNumOutputs() const { return static_cast<int>(outputs_.size()); }
+
+  /**
+   * @brief Returns the buffer of a graph output channel for the last block.
+   * @param channel The output channel index.
+   * @return Pointer to getBlockSize() samples.
+   */
+  const float *getOutputBuffer(int channel) const { return outputs_[channel]; }
+
+  /**
+   * @brief Returns the number of device input channels of the plan.
+   * @return CompileOptions::numPhysicalInputs.
+   */
+  int getNumPhysicalInputs() const {
+    return static_cast<int>(physicalInputs_.size());
+  }
+
+  /**
+   * @brief Binds the device input buffers of the next block. Real-time safe.
+   *
+   * The buffers are read in place by the Nodes, so they must stay valid
+   * until the block is processed. Channels beyond numChannels, and nullptr
+   * entries, read as silence.
+   *
+   * @param channels One buffer of getBlockSize() samples per channel.
+   * @param numChannels The number of entries in channels.
+   */
+  void setPhysicalInputs(const float *const *channels, int numChannels);
+
+private:
+  friend class WorkerPool;
+
+  /** A chain of steps run back to back by one thread. */
+  struct Task {
+    /** Index of the first step in steps_. */
+    uint32_t firstStep;
+
+    /** Number of consecutive steps. */
+    uint32_t numSteps;
+
+    /** Index of the first successor in successors_. */
+    uint32_t firstSuccessor;
+
+    /** Number of tasks that depend on this one. */
+    uint32_t numSuccessors;
+
+    /** Number of tasks this one depends on. */
+    int32_t numPredecessors;
+  };
+
+  /** One precomputed process call. */
+  struct Step {
+    /** The Node to process. */
+    Node *node;
+
+    /** Buffers and events passed to Node::process(). */
+    ProcessContext context;
+
+    /** Parameter changes of the block, sorted by offset. */
+    const RtEvent *paramEvents;
+
+    /** Number of entries in paramEvents. */
+    int numParamEvents;
+  };
+
+  /** Updates the Node's parameters and processes it. */
+  static void runStep(const Step &step) {
+    step.node->context_ = &step.context;
+    step.node->updateParams(step.paramEvents, step.numParamEvents,
+                            step.context.numFrames);
+    step.node->process(step.context);
+  }
+
+  /**
+   * Runs a step and records its timing for the given thread. Returns the
+   * end timestamp, which the next step of the same task uses as its start.
+   */
+  static uint64_t runStep(const Step &step, Profiler &profiler,
+                          int participant, uint64_t start) {
+    runStep(step);
+    const uint64_t end = Profiler::now();
+    profiler.recordNode(participant, step.node->getHandle(), start, end);
+    return end;
+  }
+
+  ExecutionPlan() = default;
+
+  /** Hands the events posted since the last block to their steps. */
+  void dispatchEvents();
+
+  /** Runs every step in order on the calling thread. */
+  void runSerial();
+
+  /** The sample rate the plan was compiled for. */
+  double sampleRate_ = 0.0;
+
+  /** The block size the plan was compiled for. */
+  int blockSize_ = 0;
+
+  /** The number of threads the plan was compiled for. */
+  int numThreads_ = 1;
+
+  /** Profiler of the running block, or nullptr if Nodes are not timed. */
+  Profiler *profiler_ = nullptr;
+
+  /** True if process(WorkerPool &) distributes tasks. */
+  bool parallel_ = false;
+
+  /** The Nodes in execution order, kept alive by the plan. */
+  std::vector<std::shared_ptr<Node>> nodes_;
+
+  /** The process calls in execution order. */
+  std::vector<Step> steps_;
+
+  /** Step index for each Node handle, or -1 for Nodes outside the plan. */
+  std::vector<int32_t> stepOfHandle_;
+
+  /** Events posted for the next block, in arrival order. */
+  std::vector<RtEvent> incoming_;
+
+  /** Number of valid entries in incoming_. */
+  size_t numIncoming_ = 0;
+
+  /** Events of the current block, grouped by step and sorted by offset. */
+  std::vector<RtEvent> events_;
+
+  /** Per-step event counts, then start offsets into events_. */
+  std::vector<uint32_t> eventStarts_;
+
+  /** Per-step number of parameter changes, stored first in each range. */
+  std::vector<uint32_t> paramEventCounts_;
+
+  /** True if some step received events in the previous block. */
+  bool hadEvents_ = false;
+
+  /** Tasks in a valid serial order. */
+  std::vector<Task> tasks_;
+
+  /** Successor task indices of all tasks, referenced by Task. */
+  std::vector<uint32_t> successors_;
+
+  /** Number of tasks without successors. */
+  int numSinks_ = 0;
+
+  /** Per-task count of unfinished predecessors for the running block. */
+  std::unique_ptr<std::atomic<int32_t>[]> pendingPredecessors_;
+
+  /** One deque per rendering thread; empty unless parallel_ is set. */
+  std::vector<std::unique_ptr<WorkStealingDeque>> deques_;
+
+  /** Input buffer pointers of all steps, referenced by Step::context. */
+  std::vector<const float *> inputPointers_;
+
+  /** Output buffer pointers of all steps, referenced by Step::context. */
+  std::vector<float *> outputPointers_;
+
+  /** Arena of every port buffer; buffer 0 is always silent. */
+  std::unique_ptr<BufferPool> buffers_;
+
+  /** Summary of the buffer assignment. */
+  BufferStats bufferStats_;
+
+  /** The buffers exposed as graph output channels. */
+  std::vector<const float *> outputs_;
+
+  /** Device input buffers of the block, referenced by Step::context. */
+  std::vector<const float *> physicalInputs_;
+};
+
+} // namespace ms
@@ -0,0 +1,145 @@
+#pragma once
+#include "Node.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @file Graph.hpp
+ * @brief Defines the editable description of a MilliSuono processing graph.
+ *
+ * A Graph is a plain container of Nodes and the connections between their
+ * Ports. It is edited on a control thread and never touched by the audio
+ * thread; ExecutionPlan::compile() turns it into something that can run.
+ */
+
+namespace ms {
+
+/**
+ * @brief A directed edge from an output port to an input port.
+ */
+struct Connection {
+  /** Identifier of the Node owning the output port. */
+  std::string sourceNode;
+
+  /** Name of the output port on the source Node. */
+  std::string sourcePort;
+
+  /** Identifier of the Node owning the input port. */
+  std::string destNode;
+
+  /** Name of the input port on the destination Node. */
+  std::string destPort;
+};
+
+/**
+ * @brief An Audio output port exposed as a channel of the graph output.
+ */
+struct GraphOutput {
+  /** Identifier of the Node owning the port. */
+  std::string node;
+
+  /** Name of the Audio output port. */
+  std::string port;
+};
+
+/**
+ * @brief Editable set of Nodes, Connections and graph outputs.
+ *
+ * Every edit is validated immediately: ports must exist, connections must go
+ * from an output to an input of the same PortType, and an input port accepts
+ * at most one connection. Cycles are detected when the graph is compiled.
+ */
+class Graph {
+public:
+  /**
+   * @brief Adds a Node to the graph.
+   * @param node The Node to add.
+   * @return True if the Node was added, false if it is null or its identifier
+   * is already used.
+   */
+  bool addNode(std::shared_ptr<Node> node);
+
+  /**
+   * @brief Removes a Node together with its connections and outputs.
+   * @param id The identifier of the Node to remove.
+   * @return True if the Node was found and removed, false otherwise.
+   */
+  bool removeNode(const std::string &id);
+
+  /**
+   * @brief Retrieves a Node by identifier.
+   * @param id The identifier of the Node.
+   * @return The Node, or nullptr if not found.
+   */
+  std::shared_ptr<Node> getNode(const std::string &id) const;
+
+  /**
+   * @brief Returns all Nodes in insertion order.
+   * @return A const reference to the vector of Nodes.
+   */
+  const std::vector<std::shared_ptr<Node>> &getNodes() const { return nodes_; }
+
+  /**
+   * @brief Connects an output port to an input port.
+   * @param sourceNode The identifier of the source Node.
+   * @param sourcePort The name of the output port on the source Node.
+   * @param destNode The identifier of the destination Node.
+   * @param destPort The name of the input port on the destination Node.
+   * @return True if the connection was added, false if a port does not exist,
+   * the port types differ or the input port is already connected.
+   */
+  bool connect(const std::string &sourceNode, const std::string &sourcePort,
+               const std::string &destNode, const std::string &destPort);
+
+  /**
+   * @brief Removes a connection.
+   * @param sourceNode The identifier of the source Node.
+   * @param sourcePort The name of the output port on the source Node.
+   * @param destNode The identifier of the destination Node.
+   * @param destPort The name of the input port on the destination Node.
+   * @return True if the connection was found and removed, false otherwise.
+   */
+  bool disconnect(const std::string &sourceNode, const std::string &sourcePort,
+                  const std::string &destNode, const std::string &destPort);
+
+  /**
+   * @brief Returns all connections in insertion order.
+   * @return A const reference to the vector of Connections.
+   */
+  const std::vector<Connection> &getConnections() const {
+    return connections_;
+  }
+
+  /**
+   * @brief Appends an Audio output port as the next graph output channel.
+   * @param node The identifier of the Node owning the port.
+   * @param port The name of the Audio output port.
+   * @return True if the output was added, false if the port does not exist or
+   * is not an Audio port.
+   */
+  bool addOutput(const std::string &node, const std::string &port);
+
+  /**
+   * @brief Returns the graph outputs, one per output channel.
+   * @return A const reference to the vector of GraphOutputs.
+   */
+  const std::vector<GraphOutput> &getOutputs() const { return outputs_; }
+
+  /**
+   * @brief Removes all graph outputs.
+   */
+  void clearOutputs() { outputs_.clear(); }
+
+private:
+  /** The Nodes of the graph in insertion order. */
+  std::vector<std::shared_ptr<Node>> nodes_;
+
+  /** The connections between Node ports. */
+  std::vector<Connection> connections_;
+
+  /** The ports exposed as graph output channels. */
+  std::vector<GraphOutput> outputs_;
+};
+
+} // namespace ms
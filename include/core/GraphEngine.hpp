@@ -0,0 +1,224 @@
+#pragma once
+#include "ExecutionPlan.hpp"
+#include "Profiler.hpp"
+#include "RtEvent.hpp"
+#include "SpscQueue.hpp"
+#include "WorkerPool.hpp"
+#include <array>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @file GraphEngine.hpp
+ * @brief Defines the engine that runs ExecutionPlans on the audio thread.
+ *
+ * Graph edits are compiled into a new ExecutionPlan on a control thread and
+ * published to the engine, which swaps it in at the next block boundary.
+ * The audio thread never waits for the control thread and never frees
+ * memory: replaced plans are handed back and destroyed off the audio thread.
+ */
+
+namespace ms {
+
+/**
+ * @brief Runs the current ExecutionPlan and swaps in new ones glitch-free.
+ *
+ * Threading contract: commit() and collectGarbage() are called from a single
+ * control thread, process() and getCurrentPlan() from the audio thread.
+ *
+ * Events reach the audio thread through EventQueues, one per producing
+ * thread. The engine owns a default queue fed by sendEvent() and
+ * sendParam(); further queues come from openEventQueue().
+ * At the start of every block all queues are drained into the current plan,
+ * which hands each Node its events sorted by sample offset.
+ *
+ * Plans compiled with CompileOptions::numThreads > 1 are rendered with the
+ * engine's WorkerPool, which grows on commit() to the largest thread count
+ * requested so far.
+ *
+ * Every block is timed by the engine's Profiler; Node timings are added
+ * while a collection started with Profiler::start() is running.
+ */
+class GraphEngine {
+public:
+  /**
+   * @brief Constructs an engine with no plan.
+   */
+  GraphEngine();
+
+  /**
+   * @brief Destroys the engine and every plan it owns.
+   *
+   * The audio thread must have stopped calling process().
+   */
+  ~GraphEngine();
+
+  GraphEngine(const GraphEngine &) = delete;
+  GraphEngine &operator=(const GraphEngine &) = delete;
+
+  /**
+   * @brief Compiles a Graph and publishes the resulting plan.
+   * @param graph The graph to compile.
+   * @param options The stream format.
+   * @param error If not null, receives a description of the failure.
+   * @return True if the graph compiled and was published, false otherwise.
+   * The running plan is left untouched on failure.
+   */
+  bool commit(const Graph &graph, const CompileOptions &options,
+              std::string *error = nullptr);
+
+  /**
+   * @brief Publishes an already compiled plan.
+   *
+   * If a previously published plan has not been picked up by the audio thread
+   * yet, it is discarded in favour of the new one. Starts the worker threads
+   * the plan needs before publishing it.
+   *
+   * @param plan The plan to run from the next block on.
+   */
+  void commit(std::unique_ptr<ExecutionPlan> plan);
+
+  /**
+   * @brief Creates an additional event queue for another producer thread.
+   *
+   * Control thread only. The returned queue may then be fed from exactly one
+   * thread of the caller's choice and lives as long as the engine.
+   *
+   * @param capacity The minimum number of events the queue can hold.
+   * @return The queue, or nullptr if kMaxEventQueues queues already exist.
+   */
+  std::shared_ptr<EventQueue> openEventQueue(size_t capacity = 1024);
+
+  /**
+   * @brief Queues a resolved event on the default queue.
+   *
+   * Control thread only. Real-time safe, so it may also be used from a
+   * thread that must not allocate.
+   *
+   * @param event The event to deliver.
+   * @return False if the default queue is full.
+   */
+  bool sendEvent(const RtEvent &event) { return defaultQueue_->push(event); }
+
+  /**
+   * @brief Resolves and queues a parameter change. Not real-time safe.
+   * @param node The Node owning the parameter.
+   * @param param The name of the parameter.
+   * @param value The new value; strings are not supported.
+   * @param sampleOffset The offset within the block at which to apply it.
+   * @param rampSeconds Length of a linear ramp to the new value; 0 uses the
+   * parameter's Smoothing, a negative value jumps.
+   * @return False if the parameter does not exist, either the value or the
+   * parameter is a string, or the queue is full.
+   */
+  bool sendParam(const Node &node, const std::string &param,
+                 const ControlValue &value, int sampleOffset = 0,
+                 float rampSeconds = 0.0f);
+
+  /**
+   * @brief Resolves and queues a string-typed Event. Not real-time safe.
+   *
+   * Use sendParam() for parameter changes; a "param_change" Event does not
+   * name its parameter and is rejected. An Event carries no velocity, so a
+   * "note_on" is sent with velocity 1; see EventTypes::NoteOn.
+   *
+   * @param node The Node the event is addressed to.
+   * @param event The event to deliver.
+   * @return False if the event cannot be converted or the queue is full.
+   */
+  bool sendEvent(const Node &node, const Event &event);
+
+  /**
+   * @brief Destroys plans the audio thread has retired.
+   *
+   * Called automatically by commit(); call it periodically if the graph is
+   * edited rarely.
+   */
+  void collectGarbage();
+
+  /**
+   * @brief Destroys every plan, so their Nodes can be compiled at another
+   * format. Not real-time safe.
+   *
+   * Only call it while process() is not running, e.g. after the audio
+   * device has been stopped.
+   */
+  void clear();
+
+  /**
+   * @brief Processes one block with the current plan.
+   *
+   * Picks up a newly published plan first, if any. Real-time safe.
+   *
+   * @return True if a plan was run, false if no plan has been published yet.
+   */
+  bool process() { return process(nullptr, 0); }
+
+  /**
+   * @brief Processes one block reading the given device input channels.
+   *
+   * The channels are bound to the plan with ExecutionPlan::setPhysicalInputs()
+   * after a new plan has been picked up. A driver whose buffers have a fixed
+   * size passes it as blockSize: a plan compiled with another block size is
+   * picked up but not run, so it never reads or writes past those buffers.
+   * Real-time safe.
+   *
+   * @param physicalInputs One buffer of blockSize samples per channel.
+   * @param numPhysicalInputs The number of entries in physicalInputs.
+   * @param blockSize The block size the caller expects, or 0 for any.
+   * @return True if a plan was run, false if no plan has been published yet
+   * or the current plan has another block size.
+   */
+  bool process(const float *const *physicalInputs, int numPhysicalInputs,
+               int blockSize = 0);
+
+  /**
+   * @brief Returns the plan used by the last call to process().
+   *
+   * Audio thread only; the plan may be retired by the next process() call.
+   *
+   * @return The current plan, or nullptr if none has been picked up yet.
+   */
+  const ExecutionPlan *getCurrentPlan() const { return current_; }
+
+  /**
+   * @brief Returns the profiler timing the engine's blocks and Nodes.
+   * @return The engine's Profiler.
+   */
+  Profiler &getProfiler() { return profiler_; }
+
+  /** Maximum number of event queues, the default one included. */
+  static constexpr size_t kMaxEventQueues = 8;
+
+private:
+  /** Number of retired plans that can wait for collection. */
+  static constexpr size_t kRetiredCapacity = 16;
+
+  /** Block and Node timing; outlives the workers that record into it. */
+  Profiler profiler_;
+
+  /** Worker threads shared by all parallel plans. */
+  WorkerPool pool_;
+
+  /** The plan published by the control thread, owned by the engine. */
+  std::atomic<ExecutionPlan *> pending_{nullptr};
+
+  /** The plan run by the audio thread, owned by the engine. */
+  ExecutionPlan *current_ = nullptr;
+
+  /** Plans replaced on the audio thread, waiting to be destroyed. */
+  SpscQueue<ExecutionPlan *> retired_;
+
+  /** Event queues drained by process(), published to the audio thread. */
+  std::array<std::atomic<EventQueue *>, kMaxEventQueues> queues_{};
+
+  /** Owning references to the queues in queues_. */
+  std::vector<std::shared_ptr<EventQueue>> ownedQueues_;
+
+  /** The queue fed by the send functions. */
+  std::shared_ptr<EventQueue> defaultQueue_;
+};
+
+} // namespace ms
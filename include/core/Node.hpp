@@ -1,5 +1,11 @@
 #pragma once
+#include "BufferPool.hpp"
+#include "ParamSmoother.hpp"
 #include "Port.hpp"
+#include "RtEvent.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -14,12 +20,51 @@
 
 namespace ms {
 
+/**
+ * @brief Buffers handed to a Node for one processing block.
+ *
+ * Both arrays are indexed like the Node's port lists: `inputs[i]` belongs to
+ * the i-th input port and `outputs[i]` to the i-th output port. Entries for
+ * non-Audio ports are nullptr. Unconnected audio inputs point to a silent
+ * buffer, so a Node never has to check for nullptr on its own audio ports.
+ */
+struct ProcessContext {
+  /** One read-only buffer of numFrames samples per input port. */
+  const float *const *inputs;
+
+  /** One writable buffer of numFrames samples per output port. */
+  float *const *outputs;
+
+  /** Number of frames to process in this block. */
+  int numFrames;
+
+  /**
+   * Events addressed to the Node in this block, sorted by sampleOffset.
+   * Parameter changes are not included: they are applied to the Node's
+   * parameters before process() is called.
+   */
+  const RtEvent *events = nullptr;
+
+  /** Number of entries in events. */
+  int numEvents = 0;
+
+  /**
+   * Device input channels of this block, deinterleaved, numFrames samples
+   * each; see Node::getPhysicalInput().
+   */
+  const float *const *physicalInputs = nullptr;
+
+  /** Number of entries in physicalInputs. */
+  int numPhysicalInputs = 0;
+};
+
 /**
  * @brief Represents a named parameter of a Node.
  *
  * A parameter stores a name and a corresponding ControlValue.
  * Parameters can represent any configurable property such as gain, frequency,
- * or mode.
+ * or mode. Float parameters may additionally be smoothed, so a single change
+ * event produces a sample-accurate ramp instead of a jump.
  */
 struct Param {
   /** The unique name identifying the parameter. */
@@ -28,13 +73,18 @@ struct Param {
   /** The current value of the parameter. */
   ControlValue value;
 
+  /** How the value moves on a change; only used for float parameters. */
+  Smoothing smoothing;
+
   /**
    * @brief Constructs a Param with a given name and value.
    * @param paramName The name of the parameter.
    * @param paramValue The value of the parameter.
+   * @param paramSmoothing How changes of a float value are smoothed.
    */
-  Param(const std::string &paramName, const ControlValue &paramValue)
-      : name(paramName), value(paramValue) {}
+  Param(const std::string &paramName, const ControlValue &paramValue,
+        const Smoothing &paramSmoothing = Smoothing())
+      : name(paramName), value(paramValue), smoothing(paramSmoothing) {}
 };
 
 /**
@@ -50,66 +100,254 @@ public:
    * @brief Constructs a Node with a given identifier.
    * @param id The unique string identifier for the Node.
    */
-  Node(const std::string &id) : id_(id) {}
+  Node(const std::string &id)
+      : id_(id), handle_(nextHandle_.fetch_add(1, std::memory_order_relaxed)) {
+  }
 
   /**
    * @brief Virtual destructor for proper cleanup in derived classes.
    */
   virtual ~Node() = default;
 
+  /**
+   * @brief Prepares the Node for processing at the given stream format.
+   *
+   * Called by the graph compiler off the audio thread. A Node that belongs
+   * to a plan may be running on the audio thread, so its state is left
+   * alone; the compiler only accepts such a Node at the format it was
+   * prepared with, see canPrepare(). Any other Node is reset, which also
+   * takes over values set with setParam() since it was last prepared.
+   *
+   * @param sampleRate The sample rate in Hz.
+   * @param blockSize The number of frames per processing block.
+   */
+  void prepare(double sampleRate, int blockSize) {
+    if (isInPlan()) {
+      return;
+    }
+    sampleRate_ = sampleRate;
+    blockSize_ = blockSize;
+    prepareParams();
+    onPrepare(sampleRate, blockSize);
+  }
+
+  /**
+   * @brief Returns true if the Node can be compiled at the given format.
+   *
+   * False if the Node belongs to a plan and was prepared with another
+   * format or another parameter list: preparing it again would free state
+   * that the audio thread may be reading.
+   *
+   * @param sampleRate The sample rate in Hz.
+   * @param blockSize The number of frames per processing block.
+   * @return True if prepare() is safe to call with this format.
+   */
+  bool canPrepare(double sampleRate, int blockSize) const {
+    return !isInPlan() ||
+           (sampleRate == sampleRate_ && blockSize == blockSize_ &&
+            smoothers_.size() == params_.size());
+  }
+
+  /**
+   * @brief Returns true while an ExecutionPlan holding the Node exists.
+   * @return True if the Node may be running on the audio thread.
+   */
+  bool isInPlan() const {
+    return numPlans_.load(std::memory_order_acquire) > 0;
+  }
+
+  /**
+   * @brief Processes one block of audio.
+   *
+   * Called on the audio thread by the execution plan, after every Node that
+   * feeds this one has processed the same block. Implementations must not
+   * allocate, lock or block. Events addressed to the Node arrive in
+   * `ctx.events`; see renderSegments() and applyEvents().
+   *
+   * @param ctx The input/output buffers and the block length.
+   */
+  virtual void process(const ProcessContext &ctx) = 0;
+
+  /**
+   * @brief Returns the sample rate the Node was last prepared with.
+   * @return The sample rate in Hz, or 0 if the Node was never prepared.
+   */
+  double getSampleRate() const { return sampleRate_; }
+
+  /**
+   * @brief Returns the block size the Node was last prepared with.
+   * @return The block size in frames, or 0 if the Node was never prepared.
+   */
+  int getBlockSize() const { return blockSize_; }
+
   /**
    * @brief Returns the unique identifier of the Node.
    * @return The Node's identifier string.
    */
   const std::string &getId() const { return id_; }
 
+  /**
+   * @brief Returns the interned handle of the Node.
+   *
+   * Handles are unique per process and never change, so an RtEvent addressed
+   * by handle stays valid across graph recompilations.
+   *
+   * @return The Node's handle.
+   */
+  uint32_t getHandle() const { return handle_; }
+
   /**
    * @brief Returns the list of parameters associated with the Node (read-only).
+   *
+   * Numeric values are the current ones, including changes sent to a
+   * running Node through the engine; a running Node may report the value of
+   * an earlier block. Control thread only: the list is refreshed on each
+   * call and the reference stays valid until the next call.
+   *
    * @return A const reference to the vector of Params.
    */
-  const std::vector<Param> &getParams() const { return params_; }
+  const std::vector<Param> &getParams() const;
 
   /**
    * @brief Returns the list of parameters associated with the Node (mutable).
-   * @return A const reference to the vector of Params.
+   *
+   * A copy to edit and pass back to setParams(), with the current values as
+   * for the const overload.
+   *
+   * @return A copy of the vector of Params.
    */
-  std::vector<Param> getParams() { return params_; }
+  std::vector<Param> getParams() {
+    return static_cast<const Node &>(*this).getParams();
+  }
 
   /**
    * @brief Retrieves a parameter value by name.
+   *
+   * The value is the current one, as for getParams(). Control thread only.
+   *
    * @param name The name of the parameter to retrieve.
-   * @return A pointer to the ControlValue if found, nullptr otherwise.
+   * @return A pointer to the ControlValue if found, nullptr otherwise. It
+   * stays valid until the next call of getParam() or getParams().
    */
   const ControlValue *getParam(const std::string &name) const {
-    for (const auto &param : params_) {
-      if (param.name == name) {
-        return &param.value;
+    const int index = findParam(name);
+    if (index < 0) {
+      return nullptr;
+    }
+    return &getParams()[index].value;
+  }
+
+  /**
+   * @brief Finds a parameter by name. Not real-time safe.
+   *
+   * The index is the parameter ID used by RtEvent::param; it stays valid
+   * until setParams() is called.
+   *
+   * @param name The name of the parameter.
+   * @return The index of the parameter in getParams(), or -1 if not found.
+   */
+  int findParam(const std::string &name) const {
+    for (size_t i = 0; i < params_.size(); ++i) {
+      if (params_[i].name == name) {
+        return static_cast<int>(i);
       }
     }
-    return nullptr;
+    return -1;
+  }
+
+  /**
+   * @brief Returns the current value of a numeric parameter as float.
+   *
+   * Includes the changes applied by the engine. While a parameter is ramping
+   * this is its value at the end of the current block; use getParamBuffer()
+   * for the per-sample values. Real-time safe, and safe to call from any
+   * thread while the Node runs; a control thread may see the value of an
+   * earlier block.
+   *
+   * @param index The index of the parameter.
+   * @return The value, or 0 for string parameters and out-of-range indices.
+   */
+  float getParamValue(size_t index) const {
+    if (index >= values_.size()) {
+      return 0.0f;
+    }
+    return values_[index].load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Returns the per-sample values of a parameter in the current block.
+   *
+   * Only float parameters that change during the block have a buffer; all
+   * others are static and should be read with getParamValue(), which lets a
+   * Node take a scalar fast path. Audio thread only.
+   *
+   * @param index The index of the parameter.
+   * @return Pointer to numFrames values, or nullptr if the parameter is
+   * static in this block.
+   */
+  const float *getParamBuffer(size_t index) const {
+    return index < paramBuffers_.size() ? paramBuffers_[index] : nullptr;
+  }
+
+  /**
+   * @brief Sets the current value of a numeric parameter. Audio thread only.
+   *
+   * The value is converted to the type the parameter was declared with and
+   * becomes what getParamValue() returns; getParams() is not changed.
+   *
+   * @param index The index of the parameter.
+   * @param value The new value.
+   * @return True if the parameter was set, false if the index is out of range
+   * or the parameter holds a string.
+   */
+  bool setParamValue(size_t index, const RtValue &value) {
+    if (index >= params_.size()) {
+      return false;
+    }
+    const ControlValue &declared = params_[index].value;
+    float converted;
+    if (std::holds_alternative<float>(declared)) {
+      converted = value.asFloat();
+    } else if (std::holds_alternative<int>(declared)) {
+      converted = static_cast<float>(value.asInt());
+    } else if (std::holds_alternative<bool>(declared)) {
+      converted = value.asBool() ? 1.0f : 0.0f;
+    } else {
+      return false;
+    }
+    values_[index].store(converted, std::memory_order_relaxed);
+    return true;
   }
 
   /**
    * @brief Sets the parameters of the Node.
+   *
+   * Only allowed while the Node is in no plan, since the audio thread may
+   * be reading the current list; the new list is taken over by the next
+   * compile. For a Node in a plan the call does nothing, reports the misuse
+   * on stderr and returns false; change the parameters of a running Node
+   * with GraphEngine::sendParam(). Earlier versions returned void and
+   * accepted the call at any time.
+   *
    * @param newParams A vector of Params to set for the Node.
+   * @return True if the parameters were set, false if the Node is in a plan.
    */
-  void setParams(const std::vector<Param> &newParams) { params_ = newParams; }
+  bool setParams(const std::vector<Param> &newParams);
 
   /**
    * @brief Sets a parameter value by name.
+   *
+   * Only allowed while the Node is in no plan, as for setParams(); the value
+   * is taken over by the next compile. For a Node in a plan the call does
+   * nothing, reports the misuse on stderr and returns false; use
+   * GraphEngine::sendParam() instead.
+   *
    * @param name The name of the parameter to set.
    * @param value The new value to assign to the parameter.
-   * @return True if the parameter was found and set, false otherwise.
+   * @return True if the parameter was found and set, false if it was not
+   * found or the Node is in a plan.
    */
-  bool setParam(const std::string &name, const ControlValue &value) {
-    for (auto &param : params_) {
-      if (param.name == name) {
-        param.value = value;
-        return true;
-      }
-    }
-    return false;
-  }
+  bool setParam(const std::string &name, const ControlValue &value);
 
   /**
    * @brief Returns the list of input ports for the Node.
@@ -123,6 +361,34 @@ public:
    */
   const std::vector<Port> &getOutputPorts() const { return outputPorts_; }
 
+  /**
+   * @brief Finds an input port by name.
+   * @param name The name of the input port.
+   * @return The index of the port in getInputPorts(), or -1 if not found.
+   */
+  int findInputPort(const std::string &name) const {
+    for (size_t i = 0; i < inputPorts_.size(); ++i) {
+      if (inputPorts_[i].name == name) {
+        return static_cast<int>(i);
+      }
+    }
+    return -1;
+  }
+
+  /**
+   * @brief Finds an output port by name.
+   * @param name The name of the output port.
+   * @return The index of the port in getOutputPorts(), or -1 if not found.
+   */
+  int findOutputPort(const std::string &name) const {
+    for (size_t i = 0; i < outputPorts_.size(); ++i) {
+      if (outputPorts_[i].name == name) {
+        return static_cast<int>(i);
+      }
+    }
+    return -1;
+  }
+
 protected:
   /** The list of input ports for the Node. */
   std::vector<Port> inputPorts_;
@@ -143,26 +409,179 @@ protected:
    * @brief Adds an output port to the Node.
    * @param name The name of the output port.
    * @param type The type of the output port.
+   * @param inPlaceInput Index of an Audio input port whose buffer this Audio
+   * output may share, or -1. A Node that declares it must produce correct
+   * output when `outputs[i] == inputs[inPlaceInput]`.
    */
-  void addOutputPort(const std::string &name, PortType type) {
-    outputPorts_.push_back(Port(name, type));
+  void addOutputPort(const std::string &name, PortType type,
+                     int inPlaceInput = -1) {
+    outputPorts_.push_back(Port(name, type, inPlaceInput));
   }
 
   /**
    * @brief Get physical audio input from hardware
    * For nodes that need direct hardware access (e.g., audio input nodes)
+   *
+   * The buffer is the device input of the current block, deinterleaved once
+   * by the driver and read in place. Only valid inside process().
+   *
    * @param channelIndex The Physical channel index to read from
    * @return Pointer to the float buffer of the physical input channel or
-   * nullptr
+   * nullptr if the plan has no such channel
    */
   const float *getPhysicalInput(int channelIndex) const;
 
+  /**
+   * @brief Handles one event addressed to the Node. Real-time safe.
+   *
+   * Parameter changes never reach this function. The default implementation
+   * ignores all events.
+   *
+   * @param event The event to handle.
+   */
+  virtual void onEvent(const RtEvent &event) { (void)event; }
+
+  /**
+   * @brief Handles all events of the block at once, before rendering.
+   *
+   * For Nodes that do not need sample accuracy.
+   *
+   * @param ctx The context passed to process().
+   */
+  void applyEvents(const ProcessContext &ctx) {
+    for (int e = 0; e < ctx.numEvents; ++e) {
+      onEvent(ctx.events[e]);
+    }
+  }
+
+  /**
+   * @brief Renders the block in segments split at the event offsets.
+   *
+   * Calls `render(start, end)` for each run of frames without events and
+   * onEvent() for every event at the frame it takes effect, so events such
+   * as notes land on the exact sample.
+   *
+   * @param ctx The context passed to process().
+   * @param render Callable taking the first and one-past-last frame.
+   */
+  template <typename Render>
+  void renderSegments(const ProcessContext &ctx, Render &&render) {
+    int start = 0;
+    for (int e = 0; e < ctx.numEvents; ++e) {
+      const int offset = ctx.events[e].sampleOffset;
+      if (offset > start) {
+        render(start, offset);
+        start = offset;
+      }
+      onEvent(ctx.events[e]);
+    }
+    if (start < ctx.numFrames) {
+      render(start, ctx.numFrames);
+    }
+  }
+
+  /**
+   * @brief Hook for allocating and resetting processing state.
+   *
+   * Called from prepare() when the Node is compiled into a plan while no
+   * other plan holds it, so it never runs concurrently with process(). This
+   * is the place to size delay lines, compute coefficients, etc.
+   *
+   * @param sampleRate The sample rate in Hz.
+   * @param blockSize The number of frames per processing block.
+   */
+  virtual void onPrepare(double sampleRate, int blockSize) {
+    (void)sampleRate;
+    (void)blockSize;
+  }
+
 private:
+  friend class ExecutionPlan;
+
+  /** Sizes the smoothing state and parameter buffers. */
+  void prepareParams();
+
+  /** Converts a numeric ControlValue to float; 0 for strings. */
+  static float toFloat(const ControlValue &value) {
+    if (auto f = std::get_if<float>(&value)) {
+      return *f;
+    }
+    if (auto i = std::get_if<int>(&value)) {
+      return static_cast<float>(*i);
+    }
+    if (auto b = std::get_if<bool>(&value)) {
+      return *b ? 1.0f : 0.0f;
+    }
+    return 0.0f;
+  }
+
+  /**
+   * Applies the block's parameter changes, sorted by offset, and renders the
+   * buffers of moving parameters. Called by ExecutionPlan before process().
+   */
+  void updateParams(const RtEvent *events, int numEvents, int numFrames) {
+    if (numEvents == 0 && !hasParamBuffers_) {
+      return;
+    }
+    renderParams(events, numEvents, numFrames);
+  }
+
+  /** Slow path of updateParams(). */
+  void renderParams(const RtEvent *events, int numEvents, int numFrames);
+
+  /** Source of Node handles. */
+  inline static std::atomic<uint32_t> nextHandle_{0};
+
   /** The unique identifier of the Node. */
   const std::string id_;
 
-  /** The list of parameters associated with the Node. */
+  /** The interned handle of the Node. */
+  const uint32_t handle_;
+
+  /**
+   * The list of parameters associated with the Node, as set on the control
+   * thread; never written while the Node is in a plan.
+   */
   std::vector<Param> params_;
+
+  /**
+   * Copy of params_ handed out by getParams(), with the current values;
+   * only touched on the control thread.
+   */
+  mutable std::vector<Param> reported_;
+
+  /**
+   * Current value of each parameter, written by the audio thread and
+   * readable from any thread.
+   */
+  std::vector<std::atomic<float>> values_;
+
+  /** The sample rate the Node was last prepared with. */
+  double sampleRate_ = 0.0;
+
+  /** The block size the Node was last prepared with. */
+  int blockSize_ = 0;
+
+  /** Smoothing state, one per parameter. */
+  std::vector<ParamSmoother> smoothers_;
+
+  /** Backing storage of the parameter buffers, one per parameter. */
+  std::unique_ptr<BufferPool> paramStorage_;
+
+  /** Per-parameter buffer of the current block, nullptr when static. */
+  std::vector<float *> paramBuffers_;
+
+  /** Per-parameter number of frames already rendered in this block. */
+  std::vector<int> paramCursors_;
+
+  /** True if some entry of paramBuffers_ is set. */
+  bool hasParamBuffers_ = false;
+
+  /** Number of ExecutionPlans holding the Node, counted by ExecutionPlan. */
+  std::atomic<int> numPlans_{0};
+
+  /** Context of the running process() call, set by ExecutionPlan. */
+  const ProcessContext *context_ = nullptr;
 };
 
 } // namespace ms
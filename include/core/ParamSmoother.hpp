@@ -0,0 +1,116 @@
+#pragma once
+
+/**
+ * @file ParamSmoother.hpp
+ * @brief Defines parameter smoothing and automation ramps.
+ */
+
+namespace ms {
+
+/**
+ * @brief How a float parameter moves towards a new value.
+ */
+struct Smoothing {
+  /**
+   * - None: jump on the exact sample of the change
+   * - Linear: straight line over `time` seconds
+   * - Exponential: constant ratio per sample over `time` seconds, for
+   *   frequencies and other log-scaled values; falls back to Linear when the
+   *   start and end values differ in sign or one is zero
+   * - OnePole: first-order lowpass with time constant `time` seconds
+   */
+  enum class Mode { None, Linear, Exponential, OnePole };
+
+  /** The ramp shape. */
+  Mode mode = Mode::None;
+
+  /** The ramp length or time constant in seconds. */
+  float time = 0.0f;
+};
+
+/**
+ * @brief Per-parameter smoothing state producing per-sample control values.
+ *
+ * A smoother is either static, holding a single value, or moving along a
+ * linear or geometric ramp. Moving ramps are rendered with the SIMD kernels
+ * of dsp::kernels(). All member functions are real-time safe.
+ */
+class ParamSmoother {
+public:
+  /**
+   * @brief Sets the default ramp used by setTarget().
+   * @param smoothing The ramp shape and time.
+   * @param sampleRate The sample rate in Hz.
+   */
+  void configure(const Smoothing &smoothing, double sampleRate) {
+    smoothing_ = smoothing;
+    sampleRate_ = sampleRate;
+  }
+
+  /**
+   * @brief Stops any ramp and holds the given value.
+   * @param value The new value.
+   */
+  void reset(float value) {
+    value_ = value;
+    target_ = value;
+    remaining_ = 0;
+  }
+
+  /**
+   * @brief Starts moving towards a new value from the current one.
+   * @param target The value to reach.
+   * @param rampSeconds Greater than zero to ramp linearly over that time,
+   * zero to use the configured Smoothing, negative to jump.
+   */
+  void setTarget(float target, float rampSeconds);
+
+  /**
+   * @brief Renders the next frames of the trajectory and advances it.
+   * @param out Receives numFrames values.
+   * @param numFrames The number of frames to render.
+   */
+  void render(float *out, int numFrames);
+
+  /**
+   * @brief Returns true if the value is still changing.
+   * @return True while a ramp is in progress.
+   */
+  bool isMoving() const { return remaining_ > 0; }
+
+  /**
+   * @brief Returns the value at the current position.
+   * @return The current value.
+   */
+  float getValue() const { return value_; }
+
+private:
+  /** Shape of the running ramp. */
+  enum class Shape { Linear, Geometric };
+
+  /** The default ramp. */
+  Smoothing smoothing_;
+
+  /** The sample rate in Hz. */
+  double sampleRate_ = 48000.0;
+
+  /** The value at the current position. */
+  float value_ = 0.0f;
+
+  /** The value at the end of the ramp. */
+  float target_ = 0.0f;
+
+  /** Frames left in the ramp; 0 when static. */
+  int remaining_ = 0;
+
+  /** Shape of the running ramp. */
+  Shape shape_ = Shape::Linear;
+
+  /** Per-frame increment (Linear) or ratio (Geometric). */
+  float step_ = 0.0f;
+
+  /** Value the geometric ramp converges to; 0 for exponential ramps. */
+  float offset_ = 0.0f;
+};
+
+} // namespace ms
@@ -75,12 +75,23 @@ struct Port {
   /** The type of the port (Audio, Control, or Event). */
   PortType type;
 
+  /**
+   * For Audio output ports: index of the Audio input port whose buffer this
+   * output may overwrite, or -1 if the node needs a separate buffer. The
+   * graph compiler only shares the buffer when no other node still needs the
+   * input signal.
+   */
+  int inPlaceInput = -1;
+
   /**
    * @brief Constructs a Port object.
    * @param name The name identifying the port.
    * @param type The port type (Audio, Control, or Event).
+   * @param inPlaceInput The input port this output may process in place, or
+   * -1.
    */
-  Port(const std::string &name, PortType type) : name(name), type(type) {}
+  Port(const std::string &name, PortType type, int inPlaceInput = -1)
+      : name(name), type(type), inPlaceInput(inPlaceInput) {}
 };
 
 } // namespace ms
@@ -0,0 +1,436 @@
+#pragma once
+#include "SpscQueue.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) ||            \
+    defined(_M_IX86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define MS_PROFILER_TSC 1
+#endif
+
+/**
+ * @file Profiler.hpp
+ * @brief Defines the real-time profiler of the engine.
+ *
+ * The audio thread and the workers time every block and, while a collection
+ * is running, every Node. Block statistics are kept in atomics the audio
+ * thread owns; Node timings go through one lock-free ring per rendering
+ * thread to a collector thread that aggregates them. Nothing the audio
+ * thread does waits for a reader.
+ *
+ * The instrumentation is compiled in when MS_PROFILING is non-zero, which
+ * the CMake option MS_ENABLE_PROFILING controls. Without it the Profiler API
+ * still exists but never records anything.
+ */
+
+#ifndef MS_PROFILING
+#define MS_PROFILING 1
+#endif
+
+namespace ms {
+
+class ExecutionPlan;
+
+/**
+ * @brief Options of a Node timing collection.
+ */
+struct ProfilerOptions {
+  /** Time between two passes of the collector thread, in milliseconds. */
+  int collectIntervalMs = 10;
+
+  /**
+   * Number of individual timings kept for writeChromeTrace(). Collection
+   * goes on once the trace is full, only the trace stops growing. 0 keeps
+   * aggregates only.
+   */
+  size_t maxTraceEvents = 0;
+};
+
+/**
+ * @brief Callback-level statistics of the engine.
+ *
+ * Loads are fractions of the block period, the time the device gives the
+ * engine to render one block: 1.0 means the block took exactly as long as
+ * it lasts when played back.
+ */
+struct BlockStats {
+  /** Number of blocks measured. */
+  uint64_t numBlocks = 0;
+
+  /** Number of blocks that took longer than their period. */
+  uint64_t numXruns = 0;
+
+  /** Total render time divided by total block period. */
+  double averageLoad = 0.0;
+
+  /** Load of the most recent block. */
+  double lastLoad = 0.0;
+
+  /** Load of the slowest block. */
+  double worstLoad = 0.0;
+
+  /** Render time of the slowest block in seconds. */
+  double worstBlockSeconds = 0.0;
+
+  /** Median load, with a resolution of one percent. */
+  double p50Load = 0.0;
+
+  /** 90th percentile of the load. */
+  double p90Load = 0.0;
+
+  /** 99th percentile of the load. */
+  double p99Load = 0.0;
+
+  /** 99.9th percentile of the load. */
+  double p999Load = 0.0;
+};
+
+/**
+ * @brief Aggregated timings of one Node.
+ */
+struct NodeProfile {
+  /** The Node's handle. */
+  uint32_t handle = 0;
+
+  /** The Node's identifier, empty if the Node was never registered. */
+  std::string id;
+
+  /** Number of timed process calls. */
+  uint64_t numCalls = 0;
+
+  /** Total time spent in the Node in seconds. */
+  double totalSeconds = 0.0;
+
+  /** Time of the slowest call in seconds. */
+  double maxSeconds = 0.0;
+
+  /** Number of xrun blocks in which this Node was the slowest one. */
+  uint64_t numXrunsCaused = 0;
+
+  /**
+   * @brief Returns the mean time of a call.
+   * @return The mean in seconds, 0 without calls.
+   */
+  double getAverageSeconds() const {
+    return numCalls > 0 ? totalSeconds / static_cast<double>(numCalls) : 0.0;
+  }
+};
+
+/**
+ * @brief Low-overhead timing of blocks and Nodes.
+ *
+ * Threading contract: beginBlock() and endBlock() are called from the audio
+ * thread, recordNode() from the rendering thread given as participant,
+ * registerNodes(), start(), stop() and reset() from a single control
+ * thread. The getters and writeChromeTrace() may be called from any thread
+ * except the audio thread; they never make it wait.
+ *
+ * Block statistics are always gathered. Node timings cost two timestamps
+ * and a ring push per process call and are only taken between start() and
+ * stop(). When a ring is full, timings are dropped rather than waited for.
+ */
+class Profiler {
+public:
+  /** Highest number of rendering threads that can be profiled. */
+  static constexpr int kMaxThreads = 64;
+
+  /** Number of timings each per-thread ring holds. */
+  static constexpr size_t kRingCapacity = 1 << 15;
+
+  /** Number of load histogram buckets, one percent each; the last is open. */
+  static constexpr int kHistogramBuckets = 400;
+
+  /**
+   * @brief Constructs an idle profiler and calibrates the timestamp clock.
+   */
+  Profiler();
+
+  /**
+   * @brief Stops the collector thread.
+   */
+  ~Profiler();
+
+  Profiler(const Profiler &) = delete;
+  Profiler &operator=(const Profiler &) = delete;
+
+  /**
+   * @brief Returns true if the instrumentation was compiled in.
+   * @return The value of MS_PROFILING.
+   */
+  static constexpr bool isCompiledIn() { return MS_PROFILING != 0; }
+
+  /**
+   * @brief Returns a timestamp. Real-time safe.
+   *
+   * Reads the time stamp counter on x86 and std::chrono::steady_clock
+   * elsewhere.
+   *
+   * @return The timestamp in ticks of getTicksPerSecond().
+   */
+  static uint64_t now() {
+#if defined(MS_PROFILER_TSC)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(
+        std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+  }
+
+  /**
+   * @brief Returns the rate of now(), measured once on first use.
+   * @return Ticks per second.
+   */
+  static double getTicksPerSecond();
+
+  /**
+   * @brief Starts collecting Node timings on a collector thread.
+   * @param options The collection options.
+   * @return False if profiling is compiled out or a collection is running.
+   */
+  bool start(const ProfilerOptions &options = ProfilerOptions());
+
+  /**
+   * @brief Stops the collection after a final pass over the rings.
+   *
+   * The aggregates and the trace are kept until reset() or the next start().
+   */
+  void stop();
+
+  /**
+   * @brief Returns true while Node timings are collected. Real-time safe.
+   * @return True between start() and stop().
+   */
+  bool isCollecting() const {
+    return collecting_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Clears the Node aggregates and the trace, and asks the audio
+   * thread to clear the block statistics at its next block.
+   */
+  void reset();
+
+  /**
+   * @brief Returns the callback-level statistics.
+   * @return A snapshot; its fields are read individually, so a block may
+   * be counted in some and not yet in others.
+   */
+  BlockStats getBlockStats() const;
+
+  /**
+   * @brief Returns the aggregated Node timings, slowest in total first.
+   * @return One entry per Node timed since the last reset.
+   */
+  std::vector<NodeProfile> getNodeProfiles() const;
+
+  /**
+   * @brief Returns the number of timings dropped because a ring was full.
+   * @return The number of dropped timings.
+   */
+  uint64_t getNumDropped() const {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Writes the collected trace in the Chrome trace event format.
+   *
+   * The file opens in chrome://tracing and Perfetto: one track per
+   * rendering thread, with blocks enclosing the Nodes run on the audio
+   * thread.
+   *
+   * @param path The JSON file to write.
+   * @param error If not null, receives a description of the failure.
+   * @return True on success.
+   */
+  bool writeChromeTrace(const std::string &path,
+                        std::string *error = nullptr) const;
+
+  /**
+   * @brief Records the identifiers of a plan's Nodes and creates the rings
+   * of its threads. Control thread, before the plan is published.
+   *
+   * Identifiers of Nodes that left the graph are kept until the next
+   * reset() or start(), so the current timings and trace can still name
+   * them.
+   *
+   * @param plan The plan about to be run.
+   */
+  void registerNodes(const ExecutionPlan &plan);
+
+  /**
+   * @brief Marks the start of a block. Audio thread only.
+   * @return The timestamp to pass to endBlock().
+   */
+  uint64_t beginBlock() {
+    block_.store(block_.load(std::memory_order_relaxed) + 1,
+                 std::memory_order_relaxed);
+    return now();
+  }
+
+  /**
+   * @brief Accounts a finished block. Audio thread only.
+   * @param start The value returned by beginBlock().
+   * @param periodSeconds How long the block lasts when played back.
+   */
+  void endBlock(uint64_t start, double periodSeconds);
+
+  /**
+   * @brief Queues the timing of one process call. Real-time safe.
+   * @param participant The rendering thread, 0 for the audio thread.
+   * @param handle The Node's handle.
+   * @param start The timestamp taken before the call.
+   * @param end The timestamp taken after the call.
+   */
+  void recordNode(int participant, uint32_t handle, uint64_t start,
+                  uint64_t end) {
+    Record record;
+    record.start = start;
+    record.end = end;
+    record.block = block_.load(std::memory_order_relaxed);
+    record.node = handle;
+    push(participant, record);
+  }
+
+private:
+  /** One timing as it travels from a rendering thread to the collector. */
+  struct Record {
+    /** Timestamp before the work. */
+    uint64_t start;
+
+    /** Timestamp after the work. */
+    uint64_t end;
+
+    /** Sequence number of the block the work belongs to. */
+    uint32_t block;
+
+    /** Node handle, or kBlockRecord / kXrunRecord for a whole block. */
+    uint32_t node;
+
+    /** Load of a whole block; unused for Nodes. */
+    float load;
+  };
+
+  /** Node value of a block that met its deadline. */
+  static constexpr uint32_t kBlockRecord = 0xFFFFFFFFu;
+
+  /** Node value of a block that missed its deadline. */
+  static constexpr uint32_t kXrunRecord = 0xFFFFFFFEu;
+
+  /** A timing kept for the trace, with the thread that produced it. */
+  struct TraceEvent {
+    Record record;
+    int thread;
+  };
+
+  /** Slowest Node seen so far in a block that is not closed yet. */
+  struct Slowest {
+    uint32_t node = 0;
+    uint64_t ticks = 0;
+  };
+
+  using Ring = SpscQueue<Record>;
+
+  /** Pushes to a participant's ring, counting the record if it is lost. */
+  void push(int participant, const Record &record) {
+    Ring *ring = participant < kMaxThreads
+                     ? rings_[participant].load(std::memory_order_acquire)
+                     : nullptr;
+    if (!ring || !ring->push(record)) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  /** Body of the collector thread. */
+  void collectLoop();
+
+  /** Drains every ring into the aggregates. Requires mutex_. */
+  void collect();
+
+  /** Adds one Node timing to the aggregates. Requires mutex_. */
+  void accumulate(const Record &record, int thread);
+
+  /** Sequence number of the running block. */
+  std::atomic<uint32_t> block_{0};
+
+  /** True between start() and stop(). */
+  std::atomic<bool> collecting_{false};
+
+  /** Set by reset(), cleared by the audio thread once it has reset. */
+  std::atomic<bool> resetRequested_{false};
+
+  /** Timings lost to full rings. */
+  std::atomic<uint64_t> dropped_{0};
+
+  /** Blocks measured; written by the audio thread only. */
+  std::atomic<uint64_t> numBlocks_{0};
+
+  /** Blocks over their period; written by the audio thread only. */
+  std::atomic<uint64_t> numXruns_{0};
+
+  /** Sum of block render times in ticks. */
+  std::atomic<uint64_t> busyTicks_{0};
+
+  /** Sum of block periods in ticks. */
+  std::atomic<uint64_t> periodTicks_{0};
+
+  /** Render time of the slowest block in ticks. */
+  std::atomic<uint64_t> worstTicks_{0};
+
+  /** Load of the most recent block. */
+  std::atomic<float> lastLoad_{0.0f};
+
+  /** Load of the slowest block, relative to its own period. */
+  std::atomic<float> worstLoad_{0.0f};
+
+  /** Block counts per percent of load. */
+  std::array<std::atomic<uint64_t>, kHistogramBuckets> histogram_{};
+
+  /** Ring of each rendering thread, published to the rendering threads. */
+  std::array<std::atomic<Ring *>, kMaxThreads> rings_{};
+
+  /** Owning references to the rings in rings_. */
+  std::vector<std::unique_ptr<Ring>> ownedRings_;
+
+  /** Guards everything below, shared by the collector and the readers. */
+  mutable std::mutex mutex_;
+
+  /** Wakes the collector thread early when stopping. */
+  std::condition_variable wake_;
+
+  /** The collector thread, joinable while collecting. */
+  std::thread collector_;
+
+  /** Options of the running collection. */
+  ProfilerOptions options_;
+
+  /** Node identifiers by handle, for the timings since the last reset. */
+  std::unordered_map<uint32_t, std::string> names_;
+
+  /** Node identifiers of the last registered plan. */
+  std::unordered_map<uint32_t, std::string> planNames_;
+
+  /** Aggregates by handle. */
+  std::unordered_map<uint32_t, NodeProfile> profiles_;
+
+  /** Slowest Node of each block whose block record is still in flight. */
+  std::unordered_map<uint32_t, Slowest> openBlocks_;
+
+  /** Timings kept for writeChromeTrace(). */
+  std::vector<TraceEvent> trace_;
+};
+
+} // namespace ms
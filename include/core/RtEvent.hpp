@@ -0,0 +1,165 @@
+#pragma once
+#include "Port.hpp"
+#include "SpscQueue.hpp"
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+/**
+ * @file RtEvent.hpp
+ * @brief Defines the allocation-free event format of the audio thread.
+ *
+ * Event and ControlValue carry strings and are convenient on control threads,
+ * but copying them may allocate. Before an event crosses into the audio
+ * thread its type, target Node and parameter are resolved to integers and
+ * its payload is reduced to a trivially copyable RtValue.
+ */
+
+namespace ms {
+
+/** Interned identifier of an event type. */
+using EventTypeId = uint32_t;
+
+/**
+ * @brief Event types known to the framework, interned at fixed IDs.
+ */
+namespace EventTypes {
+/**
+ * "param_change": sets the parameter RtEvent::param of the target Node. data
+ * is the length of a linear ramp in seconds; 0 uses the parameter's
+ * Smoothing and a negative value jumps.
+ */
+constexpr EventTypeId ParamChange = 0;
+
+/**
+ * "note_on": starts a note; value is the note number, data the velocity in
+ * (0, 1]. As in MIDI, a velocity of 0 is a note_off. RtEvent::data defaults
+ * to 0, so an RtEvent-level note_on must set its velocity explicitly.
+ */
+constexpr EventTypeId NoteOn = 1;
+
+/** "note_off": releases a note; value is the note number. */
+constexpr EventTypeId NoteOff = 2;
+} // namespace EventTypes
+
+/**
+ * @brief Returns the ID of an event type, registering it on first use.
+ *
+ * Thread-safe but not real-time safe; resolve IDs once, off the audio
+ * thread.
+ *
+ * @param name The event type name, e.g. "note_on".
+ * @return The interned ID.
+ */
+EventTypeId internEventType(const std::string &name);
+
+/**
+ * @brief Trivially copyable counterpart of the numeric ControlValues.
+ */
+struct RtValue {
+  /** The active member of the payload. */
+  enum class Kind : uint8_t { Float, Int, Bool };
+
+  /** Which member of the union is valid. */
+  Kind kind = Kind::Float;
+
+  union {
+    /** Payload for Kind::Float. */
+    float f;
+
+    /** Payload for Kind::Int. */
+    int32_t i;
+
+    /** Payload for Kind::Bool. */
+    bool b;
+  };
+
+  RtValue() : f(0.0f) {}
+
+  /**
+   * @brief Returns the payload converted to float.
+   * @return The value as a float.
+   */
+  float asFloat() const {
+    switch (kind) {
+    case Kind::Int:
+      return static_cast<float>(i);
+    case Kind::Bool:
+      return b ? 1.0f : 0.0f;
+    default:
+      return f;
+    }
+  }
+
+  /**
+   * @brief Returns the payload converted to int.
+   * @return The value as an int; floats are truncated.
+   */
+  int32_t asInt() const {
+    switch (kind) {
+    case Kind::Float:
+      return static_cast<int32_t>(f);
+    case Kind::Bool:
+      return b ? 1 : 0;
+    default:
+      return i;
+    }
+  }
+
+  /**
+   * @brief Returns the payload converted to bool.
+   * @return True if the value is non-zero.
+   */
+  bool asBool() const {
+    switch (kind) {
+    case Kind::Float:
+      return f != 0.0f;
+    case Kind::Int:
+      return i != 0;
+    default:
+      return b;
+    }
+  }
+};
+
+/**
+ * @brief Converts a ControlValue into an RtValue.
+ * @param value The value to convert.
+ * @param out Receives the converted value.
+ * @return True on success, false if value holds a string.
+ */
+bool toRtValue(const ControlValue &value, RtValue &out);
+
+/**
+ * @brief A time-stamped event as delivered on the audio thread.
+ *
+ * All names are resolved: `type` comes from internEventType(), `target` from
+ * Node::getHandle() and `param` from Node::findParam().
+ */
+struct RtEvent {
+  /** The interned event type. */
+  EventTypeId type = EventTypes::ParamChange;
+
+  /** Handle of the Node the event is addressed to. */
+  uint32_t target = 0;
+
+  /** Parameter index for EventTypes::ParamChange, unused otherwise. */
+  uint32_t param = 0;
+
+  /** Sample offset within the block at which the event takes effect. */
+  int32_t sampleOffset = 0;
+
+  /** The primary payload. */
+  RtValue value;
+
+  /** Secondary payload, e.g. the velocity of a note or a ramp length. */
+  float data = 0.0f;
+};
+
+static_assert(std::is_trivially_copyable<RtEvent>::value,
+              "RtEvent must be trivially copyable");
+
+/** Lock-free queue carrying RtEvents from one control thread to the engine. */
+using EventQueue = SpscQueue<RtEvent>;
+
+} // namespace ms
@@ -0,0 +1,114 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @file SpscQueue.hpp
+ * @brief Defines a bounded single-producer/single-consumer lock-free queue.
+ *
+ * The queue is used wherever data has to cross between a control thread and
+ * the audio thread without locks or allocation.
+ */
+
+namespace ms {
+
+/**
+ * @brief Bounded wait-free queue for exactly one producer and one consumer.
+ *
+ * Storage is allocated once in the constructor; push() and pop() never
+ * allocate, lock or block, which makes them safe to call from the audio
+ * thread. The capacity is rounded up to the next power of two.
+ *
+ * @tparam T The element type. Must be trivially copyable so that elements can
+ * be moved across threads without running user code.
+ */
+template <typename T> class SpscQueue {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "SpscQueue elements must be trivially copyable");
+
+public:
+  /**
+   * @brief Constructs a queue holding at least the given number of elements.
+   * @param capacity The minimum number of elements the queue can hold.
+   */
+  explicit SpscQueue(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity + 1) {
+      size <<= 1;
+    }
+    buffer_.resize(size);
+    mask_ = size - 1;
+  }
+
+  /**
+   * @brief Appends an element. Producer thread only.
+   * @param value The element to append.
+   * @return True if the element was queued, false if the queue is full.
+   */
+  bool push(const T &value) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    const size_t next = (tail + 1) & mask_;
+    if (next == head_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    buffer_[tail] = value;
+    tail_.store(next, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Removes the oldest element. Consumer thread only.
+   * @param value Receives the removed element.
+   * @return True if an element was removed, false if the queue is empty.
+   */
+  bool pop(T &value) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    value = buffer_[head];
+    head_.store((head + 1) & mask_, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Returns true if a push() would currently fail. Producer thread only.
+   * @return True if the queue is full.
+   */
+  bool full() const {
+    const size_t next = (tail_.load(std::memory_order_relaxed) + 1) & mask_;
+    return next == head_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief Returns true if a pop() would currently fail. Consumer thread only.
+   * @return True if the queue is empty.
+   */
+  bool empty() const {
+    return head_.load(std::memory_order_relaxed) ==
+           tail_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief Returns the number of elements the queue can hold.
+   * @return The capacity.
+   */
+  size_t capacity() const { return mask_; }
+
+private:
+  /** Ring storage; one slot is always left empty to tell full from empty. */
+  std::vector<T> buffer_;
+
+  /** Index mask, equal to buffer_.size() - 1. */
+  size_t mask_ = 0;
+
+  /** Read index, owned by the consumer. */
+  alignas(64) std::atomic<size_t> head_{0};
+
+  /** Write index, owned by the producer. */
+  alignas(64) std::atomic<size_t> tail_{0};
+};
+
+} // namespace ms
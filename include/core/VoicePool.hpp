@@ -0,0 +1,167 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+/**
+ * @file VoicePool.hpp
+ * @brief Defines the allocator that assigns notes to a fixed set of voices.
+ */
+
+namespace ms {
+
+/**
+ * @brief Preallocated voices with note tracking and voice stealing.
+ *
+ * A voice is free, held (its note is down) or released (its note is up and
+ * its sound is fading out). noteOn() takes the lowest free voice, so the
+ * voices in use stay packed at the start of the pool and a renderer that
+ * works on groups of voices touches as few groups as possible. When no
+ * voice is free a released voice is stolen first, then a held one, picked
+ * by the Stealing policy among them.
+ *
+ * Everything but the constructor and resize() is real-time safe.
+ */
+class VoicePool {
+public:
+  /** How to pick the voice to take over when all voices are in use. */
+  enum class Stealing {
+    /** Drop the new note. */
+    None,
+
+    /** Take the voice that started first. */
+    Oldest,
+
+    /** Take the voice with the lowest level. */
+    Quietest,
+  };
+
+  /**
+   * @brief Constructs a pool of free voices.
+   * @param numVoices The number of voices.
+   * @param stealing The policy used when all voices are in use.
+   */
+  explicit VoicePool(int numVoices = 0, Stealing stealing = Stealing::Oldest);
+
+  /**
+   * @brief Resizes the pool and frees every voice. Not real-time safe.
+   * @param numVoices The number of voices.
+   */
+  void resize(int numVoices);
+
+  /**
+   * @brief Frees every voice without changing the size.
+   */
+  void clear();
+
+  /**
+   * @brief Sets the stealing policy.
+   * @param stealing The policy used when all voices are in use.
+   */
+  void setStealing(Stealing stealing) { stealing_ = stealing; }
+
+  /**
+   * @brief Returns the stealing policy.
+   * @return The policy used when all voices are in use.
+   */
+  Stealing getStealing() const { return stealing_; }
+
+  /**
+   * @brief Assigns a voice to a note that starts.
+   * @param note The note number.
+   * @param levels The current level of every voice, read by
+   * Stealing::Quietest; may be nullptr for the other policies.
+   * @return The voice, now held, or -1 if the note was dropped. The voice
+   * may have been in use before; see getNumStolen().
+   */
+  int noteOn(int note, const float *levels = nullptr);
+
+  /**
+   * @brief Releases the voice of a note that stops.
+   *
+   * If the note is held by several voices the oldest is released.
+   *
+   * @param note The note number.
+   * @return The voice, now released, or -1 if no voice holds the note.
+   */
+  int noteOff(int note);
+
+  /**
+   * @brief Releases every held voice.
+   */
+  void releaseAll();
+
+  /**
+   * @brief Returns a voice to the pool once its sound has ended.
+   * @param voice The voice to free.
+   */
+  void free(int voice);
+
+  /**
+   * @brief Returns the number of voices.
+   * @return The size of the pool.
+   */
+  int getNumVoices() const { return static_cast<int>(states_.size()); }
+
+  /**
+   * @brief Returns the number of voices in use.
+   * @return The number of held and released voices.
+   */
+  int getNumActive() const { return numActive_; }
+
+  /**
+   * @brief Returns the number of notes that took over a voice in use.
+   * @return The number of stolen voices since construction.
+   */
+  uint64_t getNumStolen() const { return numStolen_; }
+
+  /**
+   * @brief Returns true if a voice is held or released.
+   * @param voice The voice.
+   * @return False if the voice is free.
+   */
+  bool isActive(int voice) const { return states_[voice] != State::Free; }
+
+  /**
+   * @brief Returns true if a voice's note is down.
+   * @param voice The voice.
+   * @return True if the voice is held.
+   */
+  bool isHeld(int voice) const { return states_[voice] == State::Held; }
+
+  /**
+   * @brief Returns the note a voice plays or last played.
+   * @param voice The voice.
+   * @return The note number.
+   */
+  int getNote(int voice) const { return notes_[voice]; }
+
+private:
+  /** Life cycle of a voice. */
+  enum class State : uint8_t { Free, Held, Released };
+
+  /** Picks a voice in the given state by the stealing policy, or -1. */
+  int findVictim(State state, const float *levels) const;
+
+  /** State of each voice. */
+  std::vector<State> states_;
+
+  /** Note of each voice. */
+  std::vector<int> notes_;
+
+  /** Value of started_ when each voice's note started. */
+  std::vector<uint64_t> ages_;
+
+  /** Number of notes started so far. */
+  uint64_t started_ = 0;
+
+  /** Number of voices that are not free. */
+  int numActive_ = 0;
+
+  /** Number of notes that took over a voice in use. */
+  uint64_t numStolen_ = 0;
+
+  /** The policy used when all voices are in use. */
+  Stealing stealing_;
+};
+
+} // namespace ms
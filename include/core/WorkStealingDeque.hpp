@@ -0,0 +1,107 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+/**
+ * @file WorkStealingDeque.hpp
+ * @brief Defines the lock-free deque used by the parallel graph scheduler.
+ */
+
+namespace ms {
+
+/**
+ * @brief Fixed-capacity Chase-Lev work-stealing deque of task indices.
+ *
+ * The owning thread pushes and pops at the bottom; any other thread may steal
+ * from the top. All operations are lock-free and never allocate. The
+ * capacity must be at least the number of items that can be queued at once,
+ * which the scheduler guarantees by sizing it to the number of tasks in a
+ * plan.
+ *
+ * Based on "Correct and Efficient Work-Stealing for Weak Memory Models"
+ * (Lê, Pop, Cohen, Zappa Nardelli, PPoPP 2013).
+ */
+class WorkStealingDeque {
+public:
+  /**
+   * @brief Constructs a deque holding at least the given number of items.
+   * @param capacity The minimum number of items the deque can hold.
+   */
+  explicit WorkStealingDeque(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    items_.reset(new std::atomic<int32_t>[size]);
+    mask_ = static_cast<int64_t>(size) - 1;
+  }
+
+  /**
+   * @brief Pushes an item at the bottom. Owner thread only.
+   * @param item The item to push.
+   */
+  void push(int32_t item) {
+    const int64_t b = bottom_.load(std::memory_order_relaxed);
+    items_[b & mask_].store(item, std::memory_order_relaxed);
+    bottom_.store(b + 1, std::memory_order_release);
+  }
+
+  /**
+   * @brief Pops the most recently pushed item. Owner thread only.
+   * @param item Receives the popped item.
+   * @return True if an item was popped, false if the deque is empty.
+   */
+  bool pop(int32_t &item) {
+    const int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top_.load(std::memory_order_relaxed);
+    if (t > b) {
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return false;
+    }
+    item = items_[b & mask_].load(std::memory_order_relaxed);
+    if (t == b) {
+      // Last item: race against thieves for it.
+      const bool won = top_.compare_exchange_strong(
+          t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return won;
+    }
+    return true;
+  }
+
+  /**
+   * @brief Steals the oldest item. Any thread.
+   * @param item Receives the stolen item.
+   * @return True if an item was stolen, false if the deque was empty or
+   * another thread won the race.
+   */
+  bool steal(int32_t &item) {
+    int64_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t b = bottom_.load(std::memory_order_acquire);
+    if (t >= b) {
+      return false;
+    }
+    item = items_[t & mask_].load(std::memory_order_relaxed);
+    return top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                        std::memory_order_relaxed);
+  }
+
+private:
+  /** Circular item storage. */
+  std::unique_ptr<std::atomic<int32_t>[]> items_;
+
+  /** Index mask, equal to the storage size - 1. */
+  int64_t mask_ = 0;
+
+  /** Steal end, advanced by thieves. */
+  alignas(64) std::atomic<int64_t> top_{0};
+
+  /** Owner end, moved by push() and pop(). */
+  alignas(64) std::atomic<int64_t> bottom_{0};
+};
+
+} // namespace ms
@@ -0,0 +1,115 @@
+#pragma once
+#include "ExecutionPlan.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @file WorkerPool.hpp
+ * @brief Defines the worker threads of the parallel graph scheduler.
+ */
+
+namespace ms {
+
+/**
+ * @brief Pinned worker threads that help the audio thread render a plan.
+ *
+ * For each block the audio thread resets the plan's dependency counters,
+ * queues the root tasks and wakes the workers. Every participant, the audio
+ * thread included, pops tasks from its own WorkStealingDeque and steals from
+ * the others when it runs dry. Finishing a task decrements the counters of
+ * its successors and queues those that become ready; the block is complete
+ * when the last sink task has finished.
+ *
+ * Between blocks workers spin briefly and then sleep, so an idle engine does
+ * not burn CPU.
+ */
+class WorkerPool {
+public:
+  /**
+   * @brief Constructs a pool without workers.
+   */
+  WorkerPool() = default;
+
+  /**
+   * @brief Stops and joins all workers.
+   */
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool &) = delete;
+  WorkerPool &operator=(const WorkerPool &) = delete;
+
+  /**
+   * @brief Starts workers until the pool has at least the given number.
+   *
+   * Control thread only; workers are never removed while the pool lives.
+   * On Linux with more than one CPU, worker i is pinned to CPU
+   * 1 + i % (CPUs - 1), so no worker runs on CPU 0. The pool does not pin
+   * the audio thread; the caller must pin it to CPU 0 for it to run alone.
+   *
+   * @param count The minimum number of worker threads.
+   */
+  void ensureWorkers(int count);
+
+  /**
+   * @brief Returns the number of worker threads.
+   * @return The number of workers, not counting the audio thread.
+   */
+  int getNumWorkers() const { return static_cast<int>(threads_.size()); }
+
+  /**
+   * @brief Renders one block of a parallel plan and waits for completion.
+   *
+   * Audio thread only. Real-time safe: the audio thread never blocks on a
+   * lock and returns once every task has run and every worker has left the
+   * plan.
+   *
+   * @param plan The plan to render.
+   */
+  void run(ExecutionPlan &plan);
+
+private:
+  /** Number of idle spins before a worker goes to sleep. */
+  static constexpr int kSpinsBeforeSleep = 20000;
+
+  /** Entry point of worker thread number index. */
+  void workerLoop(int index);
+
+  /** Executes tasks of the plan until all of its sinks have finished. */
+  void work(ExecutionPlan &plan, int participant);
+
+  /** Runs one task and releases its successors. */
+  void execute(ExecutionPlan &plan, int32_t task, int participant);
+
+  /** The worker threads. */
+  std::vector<std::thread> threads_;
+
+  /** The plan of the running block, or nullptr between blocks. */
+  std::atomic<ExecutionPlan *> plan_{nullptr};
+
+  /** Incremented once per parallel block to wake the workers. */
+  std::atomic<uint64_t> epoch_{0};
+
+  /** Sink tasks of the running block that have not finished yet. */
+  std::atomic<int> sinksRemaining_{0};
+
+  /** Workers currently inside work(). */
+  std::atomic<int> activeWorkers_{0};
+
+  /** Workers blocked on wake_. */
+  std::atomic<int> sleepingWorkers_{0};
+
+  /** Cleared to make the workers exit. */
+  std::atomic<bool> running_{true};
+
+  /** Protects the sleep/wake handshake. */
+  std::mutex mutex_;
+
+  /** Signalled when a new block starts or the pool shuts down. */
+  std::condition_variable wake_;
+};
+
+} // namespace ms
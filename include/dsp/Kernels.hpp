@@ -0,0 +1,265 @@
+#pragma once
+
+/**
+ * @file Kernels.hpp
+ * @brief Defines the runtime-dispatched SIMD kernels of the MilliSuono system.
+ *
+ * Every kernel exists as a scalar reference implementation and, on x86, as
+ * SSE2 and AVX2 variants compiled in separate translation units with the
+ * matching instruction set enabled. The best variant the CPU supports is
+ * picked once, when the first graph is compiled; nothing outside those
+ * translation units is compiled with AVX2, so the library still runs on
+ * older CPUs.
+ */
+
+namespace ms {
+namespace dsp {
+
+/**
+ * @brief Instruction set levels a kernel table can target.
+ */
+enum class SimdLevel { Scalar, SSE2, AVX2 };
+
+/**
+ * @brief Returns a printable name of a SimdLevel.
+ * @param level The level.
+ * @return "scalar", "sse2" or "avx2".
+ */
+const char *simdLevelName(SimdLevel level);
+
+/**
+ * @brief Oscillator waveforms. Saw and Square are band-limited with PolyBLEP.
+ */
+enum class Waveform { Sine, Saw, Square };
+
+/**
+ * @brief Converts the value of a "waveform" parameter.
+ * @param value 0 for Sine, 1 for Saw, 2 for Square.
+ * @return The waveform; Sine for values out of range.
+ */
+inline Waveform toWaveform(int value) {
+  switch (value) {
+  case 1:
+    return Waveform::Saw;
+  case 2:
+    return Waveform::Square;
+  default:
+    return Waveform::Sine;
+  }
+}
+
+/** Largest phase increment: just below Nyquist, where PolyBLEP is defined. */
+constexpr float kMaxIncrement = 0.49f;
+
+/**
+ * @brief Clamps an oscillator's phase increment to [0, kMaxIncrement].
+ * @param increment Frequency divided by the sample rate.
+ * @return The increment to pass to the oscillator kernels.
+ */
+inline float clampIncrement(float increment) {
+  return increment < 0.0f
+             ? 0.0f
+             : (increment > kMaxIncrement ? kMaxIncrement : increment);
+}
+
+/**
+ * @brief Normalized biquad coefficients (a0 == 1).
+ *
+ * `y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2]`
+ */
+struct BiquadCoefficients {
+  float b0 = 1.0f;
+  float b1 = 0.0f;
+  float b2 = 0.0f;
+  float a1 = 0.0f;
+  float a2 = 0.0f;
+};
+
+/**
+ * @brief Direct form I state of a biquad: the last two inputs and outputs.
+ */
+struct BiquadState {
+  float x1 = 0.0f;
+  float x2 = 0.0f;
+  float y1 = 0.0f;
+  float y2 = 0.0f;
+};
+
+/** Number of voices of a VoiceBank rendered together, one per SIMD lane. */
+constexpr int kVoiceLanes = 8;
+
+/**
+ * @brief Structure-of-arrays state of a bank of subtractive synth voices.
+ *
+ * Each voice is an oscillator feeding a biquad whose output is scaled by an
+ * envelope and panned. Every array holds one entry per voice and voices are
+ * rendered in groups of kVoiceLanes consecutive entries, so the arrays are
+ * sized to a multiple of kVoiceLanes. Free voices in a rendered group are
+ * computed too: they must hold a valid state with a level of 0.
+ *
+ * The envelope moves `level` towards `target` by `rate` per frame. A target
+ * above 1 marks the attack, which ends when the level reaches 1; the level
+ * then decays towards `sustain` at `decayRate`.
+ */
+struct VoiceBank {
+  /** Oscillator phase in [0, 1). */
+  float *phase;
+
+  /** Oscillator frequency divided by the sample rate, in (0, 0.5). */
+  float *increment;
+
+  /** Filter coefficients, as in BiquadCoefficients. */
+  float *b0;
+  float *b1;
+  float *b2;
+  float *a1;
+  float *a2;
+
+  /** Filter state, as in BiquadState. */
+  float *x1;
+  float *x2;
+  float *y1;
+  float *y2;
+
+  /** Envelope level, the level it moves towards and the rate per frame. */
+  float *level;
+  float *target;
+  float *rate;
+
+  /** Gains of the voice in the left and right output. */
+  float *gainLeft;
+  float *gainRight;
+
+  /** Scratch of kVoiceLanes floats per frame each, used to sum the lanes. */
+  float *mixLeft;
+  float *mixRight;
+
+  /** Envelope level held after the decay. */
+  float sustain = 0.0f;
+
+  /** Envelope rate of the decay. */
+  float decayRate = 1.0f;
+
+  /** Waveform of all oscillators. */
+  Waveform waveform = Waveform::Saw;
+};
+
+/**
+ * @brief Table of kernel entry points for one instruction set level.
+ *
+ * All pointers are non-null. Buffers need not be aligned.
+ */
+struct Kernels {
+  /** The instruction set level of this table. */
+  SimdLevel level;
+
+  /**
+   * Linear ramp: `out[i] = start + step * i` for i in [0, numFrames).
+   */
+  void (*fillLinear)(float *out, int numFrames, float start, float step);
+
+  /**
+   * Geometric ramp: `out[i] = offset + scale * ratio^i` for i in
+   * [0, numFrames). Covers exponential ramps (offset 0) and one-pole
+   * smoothing towards a constant target (offset = target).
+   */
+  void (*fillGeometric)(float *out, int numFrames, float offset, float scale,
+                        float ratio);
+
+  /** `out[i] = in[i] * gain`; out may equal in. */
+  void (*scale)(float *out, const float *in, int numFrames, float gain);
+
+  /** `out[i] = in[i] * gains[i]`; out may equal in. */
+  void (*multiply)(float *out, const float *in, const float *gains,
+                   int numFrames);
+
+  /** `out[i] += in[i] * gain`. */
+  void (*accumulate)(float *out, const float *in, int numFrames, float gain);
+
+  /** `out[i] += in[i] * gains[i]`. */
+  void (*accumulateMultiply)(float *out, const float *in, const float *gains,
+                             int numFrames);
+
+  /** `out[i] = sin(2 pi turns[i])`; out may equal turns. */
+  void (*sine)(float *out, const float *turns, int numFrames);
+
+  /**
+   * Oscillator at a fixed frequency. `phase` is in [0, 1) and `increment`,
+   * the frequency divided by the sample rate, in [0, 0.5).
+   * Returns the phase after the last frame.
+   */
+  float (*oscillator)(float *out, int numFrames, float phase, float increment,
+                      Waveform waveform);
+
+  /**
+   * Oscillator with a per-frame phase increment, e.g. a ramping frequency.
+   * Returns the phase after the last frame.
+   */
+  float (*oscillatorModulated)(float *out, const float *increments,
+                               int numFrames, float phase, Waveform waveform);
+
+  /**
+   * Biquad filter, updating state. The SIMD variants evaluate several
+   * outputs at once from the state-space form of the recursion. out may
+   * equal in.
+   */
+  void (*biquad)(float *out, const float *in, int numFrames,
+                 const BiquadCoefficients &coefficients, BiquadState &state);
+
+  /**
+   * Interleaves planar channels: `out[i * numChannels + c] = in[c][i]`.
+   * Stereo has a dedicated SIMD path.
+   */
+  void (*interleave)(float *out, const float *const *in, int numChannels,
+                     int numFrames);
+
+  /**
+   * Splits interleaved frames into planar channels:
+   * `out[c][i] = in[i * numChannels + c]`.
+   */
+  void (*deinterleave)(float *const *out, const float *in, int numChannels,
+                       int numFrames);
+
+  /**
+   * Renders the voice groups listed in groups and adds their mix to left
+   * and right, advancing the state in bank. Group g holds voices
+   * [g * kVoiceLanes, (g + 1) * kVoiceLanes). The SIMD variants run one
+   * voice per lane, frame by frame.
+   */
+  void (*voices)(float *left, float *right, int numFrames,
+                 const VoiceBank &bank, const int *groups, int numGroups);
+};
+
+/**
+ * @brief Selects the best kernel table for the running CPU.
+ *
+ * Reads the environment and queries the CPU on the first call, so it is
+ * not real-time safe then. ExecutionPlan::compile() calls it, which keeps
+ * that work off the audio thread. The environment variable MS_SIMD
+ * ("scalar", "sse2" or "avx2") caps the level, which is useful to compare
+ * paths on one machine.
+ *
+ * @return The selected kernel table.
+ */
+const Kernels &initKernels();
+
+/**
+ * @brief Returns the kernel table chosen by initKernels().
+ *
+ * Real-time safe once initKernels() has run, which every compiled plan
+ * guarantees; before that it calls initKernels() itself.
+ *
+ * @return The selected kernel table.
+ */
+const Kernels &kernels();
+
+/**
+ * @brief Returns the kernel table of a specific level.
+ * @param level The requested level.
+ * @return The table, or nullptr if it was not compiled in or the CPU does
+ * not support it.
+ */
+const Kernels *kernelsFor(SimdLevel level);
+
+} // namespace dsp
+} // namespace ms
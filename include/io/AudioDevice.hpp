@@ -0,0 +1,204 @@
+#pragma once
+#include "core/GraphEngine.hpp"
+#include "io/BlockAdapter.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/**
+ * @file AudioDevice.hpp
+ * @brief Defines the driver that runs a graph on an audio device.
+ */
+
+namespace ms {
+
+/**
+ * @brief Settings of an AudioDevice.
+ */
+struct AudioDeviceOptions {
+  /** Which miniaudio backend to use. */
+  enum class Backend {
+    /** The platform's preferred backend and default device. */
+    Default,
+    /**
+     * miniaudio's null backend: no hardware, silent input, discarded
+     * output, paced by a timer. For testing and CI.
+     */
+    Null,
+  };
+
+  /** The backend. */
+  Backend backend = Backend::Default;
+
+  /** The requested sample rate in Hz; the device may choose another. */
+  double sampleRate = 48000.0;
+
+  /** The number of frames per processing block. */
+  int blockSize = 256;
+
+  /** Threads rendering each block; see CompileOptions::numThreads. */
+  int numThreads = 1;
+
+  /** Device input channels; 0 opens no capture side. */
+  int numInputs = 0;
+
+  /** Device output channels; 0 opens no playback side. */
+  int numOutputs = 2;
+
+  /**
+   * Requested frames per callback, 0 for the block size. Only a hint: the
+   * callback size may differ and vary, which BlockAdapter absorbs.
+   */
+  int periodFrames = 0;
+
+  /**
+   * Makes miniaudio deliver callbacks of exactly periodFrames frames, at
+   * the cost of one extra copy inside miniaudio. With inputs and outputs
+   * this lowers the latency BlockAdapter adds from blockSize - 1 to
+   * blockSize - gcd(periodFrames, blockSize), none for a period that is a
+   * multiple of the block size.
+   */
+  bool fixedPeriod = false;
+};
+
+/**
+ * @brief Runs a Graph from the callbacks of a miniaudio device.
+ *
+ * The device is opened with 32-bit float samples and, unless
+ * AudioDeviceOptions::fixedPeriod is set, without miniaudio's own
+ * fixed-size callback buffering; a BlockAdapter re-blocks the callbacks,
+ * deinterleaving input into the graph's physical inputs and
+ * interleaving graph outputs into the device buffer. Graph output i feeds
+ * device output channel i; missing channels are silent.
+ *
+ * Threading contract: the device's callback thread is the engine's audio
+ * thread. Everything else, including getEngine(), belongs to one control
+ * thread.
+ */
+class AudioDevice {
+public:
+  /**
+   * @brief Constructs a closed device.
+   */
+  AudioDevice();
+
+  /**
+   * @brief Stops and closes the device.
+   */
+  ~AudioDevice();
+
+  AudioDevice(const AudioDevice &) = delete;
+  AudioDevice &operator=(const AudioDevice &) = delete;
+
+  /**
+   * @brief Opens the device and compiles the graph for its format.
+   *
+   * The graph is compiled with the sample rate the device actually runs at
+   * and with options.numInputs physical inputs. Closes a previously opened
+   * device first.
+   *
+   * @param graph The graph to run.
+   * @param options The device, stream format and threading settings.
+   * @param error If not null, receives a description of the failure.
+   * @return True on success.
+   */
+  bool open(const Graph &graph, const AudioDeviceOptions &options,
+            std::string *error = nullptr);
+
+  /**
+   * @brief Starts the callbacks.
+   * @param error If not null, receives a description of the failure.
+   * @return True on success.
+   */
+  bool start(std::string *error = nullptr);
+
+  /**
+   * @brief Stops the callbacks; returns once the last one has finished.
+   * @param error If not null, receives a description of the failure.
+   * @return True on success or if the device was not running.
+   */
+  bool stop(std::string *error = nullptr);
+
+  /**
+   * @brief Stops and closes the device and releases the graph.
+   */
+  void close();
+
+  /**
+   * @brief Returns true between a successful open() and close().
+   * @return True if the device is open.
+   */
+  bool isOpen() const { return device_ != nullptr; }
+
+  /**
+   * @brief Returns the engine running the graph.
+   *
+   * Plans committed to it must use getBlockSize(), getSampleRate() and at
+   * most AudioDeviceOptions::numInputs physical inputs.
+   *
+   * @return The engine.
+   */
+  GraphEngine &getEngine() { return engine_; }
+
+  /**
+   * @brief Returns the sample rate the device runs at.
+   * @return The sample rate in Hz, or 0 if closed.
+   */
+  double getSampleRate() const { return sampleRate_; }
+
+  /**
+   * @brief Returns the block size of the graph.
+   * @return The block size in frames.
+   */
+  int getBlockSize() const { return options_.blockSize; }
+
+  /**
+   * @brief Returns the latency added by re-blocking callbacks into blocks.
+   * @return The latency in frames; see BlockAdapter::getLatencyFrames().
+   */
+  int getLatencyFrames() const {
+    return adapter_ ? adapter_->getLatencyFrames() : 0;
+  }
+
+  /**
+   * @brief Returns the number of callbacks since open().
+   * @return The callback count.
+   */
+  uint64_t getNumCallbacks() const {
+    return callbacks_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Returns the number of frames handled since open().
+   * @return The frame count.
+   */
+  uint64_t getFramesProcessed() const {
+    return frames_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Returns the number of blocks output as silence for lack of input.
+   * @return The underrun count.
+   */
+  uint64_t getNumUnderruns() const {
+    return adapter_ ? adapter_->getNumUnderruns() : 0;
+  }
+
+private:
+  /** miniaudio context and device; defined in the implementation. */
+  struct Device;
+
+  /** Entry point of the device thread. */
+  void onCallback(void *output, const void *input, uint32_t numFrames);
+
+  AudioDeviceOptions options_;
+  GraphEngine engine_;
+  std::unique_ptr<Device> device_;
+  std::unique_ptr<BlockAdapter> adapter_;
+  double sampleRate_ = 0.0;
+  std::atomic<uint64_t> callbacks_{0};
+  std::atomic<uint64_t> frames_{0};
+};
+
+} // namespace ms
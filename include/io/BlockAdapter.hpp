@@ -0,0 +1,148 @@
+#pragma once
+#include "core/BufferPool.hpp"
+#include "core/GraphEngine.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * @file BlockAdapter.hpp
+ * @brief Defines the re-blocking layer between device callbacks and a graph.
+ */
+
+namespace ms {
+
+/**
+ * @brief Runs a GraphEngine from device callbacks of any size.
+ *
+ * Devices deliver interleaved buffers of a size they choose, possibly
+ * different on every callback, while a plan always processes blocks of
+ * fixed size. The adapter bridges the two with a single pass over the data
+ * in each direction:
+ *
+ * - Input is deinterleaved straight into a per-channel ring whose capacity
+ *   is a multiple of the block size. Blocks are read at block-aligned
+ *   positions, so every block is contiguous and is handed to the plan in
+ *   place as its physical inputs.
+ * - Output is interleaved straight from the plan's output buffers into the
+ *   device buffer. Frames of a block that do not fit into the current
+ *   callback stay in the plan until the next one; a block is only
+ *   processed when the device needs its first frame.
+ *
+ * When the device has inputs and outputs, a block can only run once all of
+ * its input has arrived, so the input ring starts primed with silence; see
+ * getLatencyFrames().
+ */
+class BlockAdapter {
+public:
+  /**
+   * @brief Constructs an adapter. Not real-time safe.
+   * @param engine The engine to drive. Every plan committed to it must use
+   * blockSize and at most numInputs physical inputs.
+   * @param blockSize The block size of the plans.
+   * @param numInputs Interleaved channels of the device input.
+   * @param numOutputs Interleaved channels of the device output.
+   * @param maxCallbackFrames The largest callback handled in one piece;
+   * larger ones are split.
+   * @param fixedCallbackFrames The callback size if the device guarantees
+   * one, or 0 if it may vary. A fixed size that is a multiple of blockSize
+   * adds no latency.
+   */
+  BlockAdapter(GraphEngine &engine, int blockSize, int numInputs,
+               int numOutputs, int maxCallbackFrames,
+               int fixedCallbackFrames = 0);
+
+  BlockAdapter(const BlockAdapter &) = delete;
+  BlockAdapter &operator=(const BlockAdapter &) = delete;
+
+  /**
+   * @brief Handles one device callback. Real-time safe.
+   *
+   * Acts as the audio thread of the engine.
+   *
+   * @param input numFrames interleaved input frames, or nullptr for silence.
+   * @param output Receives numFrames interleaved output frames; may be
+   * nullptr for capture-only devices.
+   * @param numFrames The number of frames of the callback.
+   */
+  void process(const float *input, float *output, int numFrames);
+
+  /**
+   * @brief Returns the latency added by re-blocking.
+   *
+   * With both inputs and outputs this is the number of silent frames the
+   * input ring starts with: blockSize - gcd(fixedCallbackFrames, blockSize)
+   * for a fixed callback size and blockSize - 1 for a variable one. The
+   * round trip from device input to device output grows by this many
+   * frames. Without inputs, blocks are rendered on demand and nothing is
+   * added.
+   *
+   * @return The latency in frames.
+   */
+  int getLatencyFrames() const { return latency_; }
+
+  /**
+   * @brief Returns how often output had to be filled with silence because
+   * no input block was complete or the engine's plan has another block
+   * size. Stays 0 unless the device delivers more than maxCallbackFrames
+   * frames in a way the latency does not cover, or a plan breaks the
+   * constructor's contract.
+   * @return The number of underruns.
+   */
+  uint64_t getNumUnderruns() const {
+    return underruns_.load(std::memory_order_relaxed);
+  }
+
+private:
+  /** Deinterleaves numFrames frames into the input ring. */
+  void writeInput(const float *input, int numFrames);
+
+  /** Interleaves numFrames frames of plan output, running blocks on demand. */
+  void writeOutput(float *output, int numFrames);
+
+  /** Processes the next block; false if its input is incomplete. */
+  bool runBlock();
+
+  GraphEngine &engine_;
+  const int blockSize_;
+  const int numInputs_;
+  const int numOutputs_;
+
+  /** Callbacks are handled in chunks of at most this many frames. */
+  int maxChunk_ = 0;
+
+  /** Silent frames the input ring is primed with. */
+  int latency_ = 0;
+
+  /** Per-channel input ring, capacity_ frames each. */
+  std::unique_ptr<BufferPool> ring_;
+
+  /** Ring capacity in frames, a multiple of blockSize_. */
+  int capacity_ = 0;
+
+  /** Start of the next block in the ring, a multiple of blockSize_. */
+  int readPosition_ = 0;
+
+  /** Frames in the ring not yet consumed by a block. */
+  int available_ = 0;
+
+  /** Frames of the last block not yet written to the device. */
+  int blockRemaining_ = 0;
+
+  /** One block of silence for missing output channels. */
+  std::vector<float> silence_;
+
+  /** Ring write positions passed to the deinterleave kernel. */
+  std::vector<float *> inputChannels_;
+
+  /** Block inputs passed to the engine. */
+  std::vector<const float *> physicalInputs_;
+
+  /** Plan outputs passed to the interleave kernel. */
+  std::vector<const float *> outputChannels_;
+
+  std::atomic<uint64_t> underruns_{0};
+};
+
+} // namespace ms
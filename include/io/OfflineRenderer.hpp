@@ -0,0 +1,232 @@
+#pragma once
+#include "core/GraphEngine.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @file OfflineRenderer.hpp
+ * @brief Defines the offline driver that renders a graph to a file.
+ *
+ * No audio device is involved: blocks are rendered as fast as the CPU
+ * allows and streamed to disk in fixed-size chunks, so memory use does not
+ * depend on the length of the render.
+ */
+
+namespace ms {
+
+/**
+ * @brief Settings of an offline render.
+ */
+struct OfflineRenderOptions {
+  /** Container of the output file. */
+  enum class FileFormat {
+    /** RIFF WAV written by miniaudio's encoder; limited to 4 GiB. */
+    Wav,
+    /** Headerless interleaved samples. */
+    Raw,
+  };
+
+  /** Sample encoding of the output file. */
+  enum class SampleFormat { Float32, Int16, Int24, Int32 };
+
+  /** Noise added before requantizing to an integer format. */
+  enum class Dither {
+    /** Round to the nearest step; the output depends only on the graph. */
+    None,
+    /**
+     * Triangular noise of one step, from a generator owned by the renderer
+     * and reseeded by every open(), so renders stay reproducible.
+     */
+    Triangle,
+  };
+
+  /** The sample rate in Hz. */
+  double sampleRate = 48000.0;
+
+  /** The number of frames per processing block. */
+  int blockSize = 256;
+
+  /** Threads rendering each block; see CompileOptions::numThreads. */
+  int numThreads = 1;
+
+  /** The file container. */
+  FileFormat fileFormat = FileFormat::Wav;
+
+  /** The sample encoding. */
+  SampleFormat sampleFormat = SampleFormat::Float32;
+
+  /** Dither applied to integer sample formats. */
+  Dither dither = Dither::None;
+
+  /** Frames buffered between two writes to the file. */
+  int chunkFrames = 16384;
+};
+
+/**
+ * @brief Throughput of an offline render.
+ */
+struct OfflineRenderStats {
+  /** Frames written to the file so far. */
+  uint64_t framesRendered = 0;
+
+  /** Length of the rendered audio in seconds. */
+  double audioSeconds = 0.0;
+
+  /** Wall-clock time spent processing blocks, in seconds. */
+  double processSeconds = 0.0;
+
+  /** Wall-clock time including format conversion and file writes. */
+  double totalSeconds = 0.0;
+
+  /**
+   * @brief Returns how many times faster than real time the render ran.
+   * @return audioSeconds / totalSeconds, or 0 before the first frame.
+   */
+  double getRealtimeFactor() const {
+    return totalSeconds > 0.0 ? audioSeconds / totalSeconds : 0.0;
+  }
+};
+
+/**
+ * @brief Renders a Graph into a WAV or raw file, faster than real time.
+ *
+ * The renderer owns a GraphEngine. Events and parameter changes sent to
+ * getEngine() between two render() calls take effect at the next block
+ * boundary, so automation can be scripted by rendering in segments.
+ * Each graph output becomes one channel of the file.
+ *
+ * Typical use:
+ * @code
+ * OfflineRenderer renderer(options);
+ * renderer.open(graph, "out.wav", &error);
+ * renderer.render(seconds * options.sampleRate, &error);
+ * renderer.close(&error);
+ * @endcode
+ */
+class OfflineRenderer {
+public:
+  /**
+   * @brief Constructs a renderer.
+   * @param options The stream format, threading and file settings.
+   */
+  explicit OfflineRenderer(const OfflineRenderOptions &options = {});
+
+  /**
+   * @brief Finalizes the file if it is still open.
+   */
+  ~OfflineRenderer();
+
+  OfflineRenderer(const OfflineRenderer &) = delete;
+  OfflineRenderer &operator=(const OfflineRenderer &) = delete;
+
+  /**
+   * @brief Compiles a Graph and creates the output file.
+   * @param graph The graph to render; it needs at least one output.
+   * @param path The file to create or overwrite.
+   * @param error If not null, receives a description of the failure.
+   * @return True on success.
+   */
+  bool open(const Graph &graph, const std::string &path,
+            std::string *error = nullptr);
+
+  /**
+   * @brief Renders frames and streams them to the file.
+   *
+   * The count need not be a multiple of the block size: frames left over
+   * from the last block are written by the next call.
+   *
+   * @param numFrames The number of frames to render.
+   * @param error If not null, receives a description of the failure.
+   * @return True on success, false if no file is open or a write failed.
+   */
+  bool render(uint64_t numFrames, std::string *error = nullptr);
+
+  /**
+   * @brief Writes the buffered frames, finalizes the file and releases the
+   * graph.
+   * @param error If not null, receives a description of the failure.
+   * @return True on success or if no file was open.
+   */
+  bool close(std::string *error = nullptr);
+
+  /**
+   * @brief Returns the engine running the graph.
+   *
+   * The caller acts as its control thread, e.g. to send events or commit an
+   * edited graph between render() calls. Plans committed to it must use
+   * OfflineRenderOptions::blockSize; render() fails on any other.
+   *
+   * @return The engine.
+   */
+  GraphEngine &getEngine() { return engine_; }
+
+  /**
+   * @brief Returns the throughput of the current or last render.
+   * @return The statistics.
+   */
+  const OfflineRenderStats &getStats() const { return stats_; }
+
+  /**
+   * @brief Returns the settings the renderer was constructed with.
+   * @return The options.
+   */
+  const OfflineRenderOptions &getOptions() const { return options_; }
+
+private:
+  /** Encoder state; defined in the implementation to keep miniaudio out. */
+  struct Writer;
+
+  /** Converts and writes the first chunkFill_ frames of chunk_. */
+  bool flush(std::string *error);
+
+  /** Adds triangular noise of one step of the file's format to chunk_. */
+  void addDither();
+
+  OfflineRenderOptions options_;
+  GraphEngine engine_;
+  std::unique_ptr<Writer> writer_;
+  OfflineRenderStats stats_;
+
+  /** Number of channels in the file. */
+  int numChannels_ = 0;
+
+  /** Frames of the last processed block not yet copied into chunk_. */
+  int blockRemaining_ = 0;
+
+  /** Interleaved float frames waiting to be written. */
+  std::vector<float> chunk_;
+
+  /** chunk_ converted to the file's sample format. */
+  std::vector<uint8_t> encoded_;
+
+  /** Number of frames in chunk_. */
+  int chunkFill_ = 0;
+
+  /** State of the dither noise generator. */
+  uint32_t ditherState_ = 0;
+
+  /** Plan outputs passed to the interleave kernel. */
+  std::vector<const float *> channels_;
+
+  /** One block of silence for channels the plan does not provide. */
+  std::vector<float> silence_;
+};
+
+/**
+ * @brief Renders a Graph into a file in one call.
+ * @param graph The graph to render.
+ * @param path The file to create or overwrite.
+ * @param seconds The length of the render.
+ * @param options The stream format, threading and file settings.
+ * @param stats If not null, receives the throughput.
+ * @param error If not null, receives a description of the failure.
+ * @return True on success.
+ */
+bool renderToFile(const Graph &graph, const std::string &path, double seconds,
+                  const OfflineRenderOptions &options = {},
+                  OfflineRenderStats *stats = nullptr,
+                  std::string *error = nullptr);
+
+} // namespace ms
@@ -0,0 +1,48 @@
+#pragma once
+#include "core/Node.hpp"
+
+/**
+ * @file AudioInputNode.hpp
+ * @brief Defines the Node reading a device input channel.
+ */
+
+namespace ms {
+
+/**
+ * @brief Brings one physical input channel into the graph.
+ *
+ * Reads the channel through getPhysicalInput(), which points into the
+ * driver's deinterleaved input, and applies the gain in the same pass. Reads
+ * silence if the plan has no such channel; see
+ * CompileOptions::numPhysicalInputs.
+ *
+ * Parameter: "gain" (float, linear amplitude), smoothed linearly.
+ *
+ * Output: "out" (Audio).
+ */
+class AudioInputNode : public Node {
+public:
+  /** Index of the "gain" parameter. */
+  static constexpr size_t kGain = 0;
+
+  /**
+   * @brief Constructs an AudioInputNode.
+   * @param id The unique identifier of the Node.
+   * @param channel The physical input channel to read.
+   * @param gain The initial gain.
+   */
+  AudioInputNode(const std::string &id, int channel, float gain = 1.0f);
+
+  /**
+   * @brief Returns the physical input channel the Node reads.
+   * @return The channel index.
+   */
+  int getChannel() const { return channel_; }
+
+  void process(const ProcessContext &ctx) override;
+
+private:
+  int channel_;
+};
+
+} // namespace ms
@@ -0,0 +1,83 @@
+#pragma once
+#include "core/Node.hpp"
+#include "dsp/Kernels.hpp"
+
+/**
+ * @file BiquadNode.hpp
+ * @brief Defines the biquad filter Node.
+ */
+
+namespace ms {
+
+/**
+ * @brief Second-order lowpass, highpass or bandpass filter.
+ *
+ * Coefficients follow the RBJ audio EQ cookbook. They are recomputed only
+ * when a parameter changes; while cutoff or Q ramp the block is filtered in
+ * sub-blocks with coefficients updated between them.
+ *
+ * Parameters:
+ * - "cutoff" (float, Hz): smoothed exponentially
+ * - "q" (float): smoothed linearly
+ * - "mode" (int): a BiquadNode::Mode
+ *
+ * Input: "in" (Audio). Output: "out" (Audio), processed in place.
+ */
+class BiquadNode : public Node {
+public:
+  /** Filter responses. */
+  enum class Mode { Lowpass = 0, Highpass = 1, Bandpass = 2 };
+
+  /** Index of the "cutoff" parameter. */
+  static constexpr size_t kCutoff = 0;
+
+  /** Index of the "q" parameter. */
+  static constexpr size_t kQ = 1;
+
+  /** Index of the "mode" parameter. */
+  static constexpr size_t kMode = 2;
+
+  /** Frames per coefficient update while cutoff or Q move. */
+  static constexpr int kModulationInterval = 32;
+
+  /**
+   * @brief Constructs a BiquadNode.
+   * @param id The unique identifier of the Node.
+   * @param mode The filter response.
+   * @param cutoff The initial cutoff frequency in Hz.
+   * @param q The initial quality factor.
+   */
+  BiquadNode(const std::string &id, Mode mode = Mode::Lowpass,
+             float cutoff = 1000.0f, float q = 0.7071f);
+
+  /**
+   * @brief Computes filter coefficients. Real-time safe.
+   * @param mode The filter response.
+   * @param cutoff The cutoff or center frequency in Hz, clamped to
+   * [10 Hz, 0.49 * sampleRate].
+   * @param q The quality factor, at least 0.1.
+   * @param sampleRate The sample rate in Hz.
+   * @return The normalized coefficients.
+   */
+  static dsp::BiquadCoefficients design(Mode mode, float cutoff, float q,
+                                        double sampleRate);
+
+  void process(const ProcessContext &ctx) override;
+
+protected:
+  void onPrepare(double sampleRate, int blockSize) override;
+
+private:
+  /** Recomputes coefficients_ if any of the inputs differ from the cache. */
+  void updateCoefficients(Mode mode, float cutoff, float q);
+
+  dsp::BiquadCoefficients coefficients_;
+  dsp::BiquadState state_;
+
+  /** The inputs coefficients_ were computed from. */
+  Mode designedMode_ = Mode::Lowpass;
+  float designedCutoff_ = -1.0f;
+  float designedQ_ = -1.0f;
+};
+
+} // namespace ms
@@ -0,0 +1,33 @@
+#pragma once
+#include "core/Node.hpp"
+
+/**
+ * @file GainNode.hpp
+ * @brief Defines the gain Node.
+ */
+
+namespace ms {
+
+/**
+ * @brief Multiplies its input by a gain.
+ *
+ * Parameter: "gain" (float, linear amplitude), smoothed linearly.
+ *
+ * Input: "in" (Audio). Output: "out" (Audio), processed in place.
+ */
+class GainNode : public Node {
+public:
+  /** Index of the "gain" parameter. */
+  static constexpr size_t kGain = 0;
+
+  /**
+   * @brief Constructs a GainNode.
+   * @param id The unique identifier of the Node.
+   * @param gain The initial gain.
+   */
+  GainNode(const std::string &id, float gain = 1.0f);
+
+  void process(const ProcessContext &ctx) override;
+};
+
+} // namespace ms
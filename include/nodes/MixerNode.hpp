@@ -0,0 +1,32 @@
+#pragma once
+#include "core/Node.hpp"
+
+/**
+ * @file MixerNode.hpp
+ * @brief Defines the N-input mixer Node.
+ */
+
+namespace ms {
+
+/**
+ * @brief Sums N audio inputs, each with its own gain.
+ *
+ * Parameters: "gain0" ... "gain<N-1>" (float), smoothed linearly. Inputs
+ * with a static gain of 0 are skipped.
+ *
+ * Inputs: "in0" ... "in<N-1>" (Audio). Output: "out" (Audio), which may
+ * share the buffer of "in0".
+ */
+class MixerNode : public Node {
+public:
+  /**
+   * @brief Constructs a MixerNode.
+   * @param id The unique identifier of the Node.
+   * @param numInputs The number of inputs, at least 1.
+   */
+  MixerNode(const std::string &id, int numInputs);
+
+  void process(const ProcessContext &ctx) override;
+};
+
+} // namespace ms
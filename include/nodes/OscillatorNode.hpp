@@ -0,0 +1,53 @@
+#pragma once
+#include "core/Node.hpp"
+#include "dsp/Kernels.hpp"
+#include <vector>
+
+/**
+ * @file OscillatorNode.hpp
+ * @brief Defines the band-limited oscillator Node.
+ */
+
+namespace ms {
+
+/**
+ * @brief Generates a sine, saw or square wave.
+ *
+ * Parameters:
+ * - "frequency" (float, Hz): smoothed exponentially, so glides sound even
+ *   across octaves; clamped below the Nyquist frequency
+ * - "waveform" (int): 0 sine, 1 saw, 2 square
+ *
+ * Output: "out" (Audio).
+ */
+class OscillatorNode : public Node {
+public:
+  /** Index of the "frequency" parameter. */
+  static constexpr size_t kFrequency = 0;
+
+  /** Index of the "waveform" parameter. */
+  static constexpr size_t kWaveform = 1;
+
+  /**
+   * @brief Constructs an OscillatorNode.
+   * @param id The unique identifier of the Node.
+   * @param frequency The initial frequency in Hz.
+   * @param waveform The initial waveform.
+   */
+  OscillatorNode(const std::string &id, float frequency = 440.0f,
+                 dsp::Waveform waveform = dsp::Waveform::Sine);
+
+  void process(const ProcessContext &ctx) override;
+
+protected:
+  void onPrepare(double sampleRate, int blockSize) override;
+
+private:
+  /** Phase in [0, 1). */
+  float phase_ = 0.0f;
+
+  /** Per-sample phase increments while the frequency moves. */
+  std::vector<float> increments_;
+};
+
+} // namespace ms
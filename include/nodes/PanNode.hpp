@@ -0,0 +1,46 @@
+#pragma once
+#include "core/Node.hpp"
+#include <vector>
+
+/**
+ * @file PanNode.hpp
+ * @brief Defines the constant-power panner Node.
+ */
+
+namespace ms {
+
+/**
+ * @brief Pans a mono input between two outputs at constant power.
+ *
+ * With `theta = (pan + 1) * pi / 4` the gains are cos(theta) on the left and
+ * sin(theta) on the right, -3 dB each at the center.
+ *
+ * Parameter: "pan" (float, -1 left to 1 right), smoothed linearly.
+ *
+ * Input: "in" (Audio). Outputs: "left" (Audio), which may share the buffer
+ * of "in", and "right" (Audio).
+ */
+class PanNode : public Node {
+public:
+  /** Index of the "pan" parameter. */
+  static constexpr size_t kPan = 0;
+
+  /**
+   * @brief Constructs a PanNode.
+   * @param id The unique identifier of the Node.
+   * @param pan The initial position.
+   */
+  PanNode(const std::string &id, float pan = 0.0f);
+
+  void process(const ProcessContext &ctx) override;
+
+protected:
+  void onPrepare(double sampleRate, int blockSize) override;
+
+private:
+  /** Per-sample gains while the position moves. */
+  std::vector<float> leftGains_;
+  std::vector<float> rightGains_;
+};
+
+} // namespace ms
@@ -0,0 +1,150 @@
+#pragma once
+#include "core/Node.hpp"
+#include "core/VoicePool.hpp"
+#include "dsp/Kernels.hpp"
+#include <vector>
+
+/**
+ * @file PolySynthNode.hpp
+ * @brief Defines the polyphonic subtractive synthesizer Node.
+ */
+
+namespace ms {
+
+/**
+ * @brief Renders a pool of oscillator-filter-envelope voices in one Node.
+ *
+ * Instead of one oscillator, filter and envelope Node per voice, the voice
+ * template is instantiated once with its state in a dsp::VoiceBank, one
+ * array per state variable. Kernels::voices renders kVoiceLanes voices at
+ * a time, one per SIMD lane, and only the groups holding active voices.
+ *
+ * Notes come from "note_on" (value: note number, data: velocity; a
+ * velocity of 0 releases, see EventTypes::NoteOn) and "note_off" events,
+ * applied at their sample offset. Voices are assigned by a VoicePool. A
+ * stolen voice keeps its phase, filter state and level, so it glides into
+ * the new note instead of clicking.
+ *
+ * Parameters, read once per block:
+ * - "waveform" (int): 0 sine, 1 saw, 2 square
+ * - "cutoff" (float, Hz): lowpass cutoff at middle C
+ * - "q" (float): lowpass quality factor
+ * - "keytrack" (float): how far the cutoff follows the note, 0 to 1
+ * - "attack" (float, s): time to full level
+ * - "decay" (float, s): time to fall 60 dB towards the sustain level
+ * - "sustain" (float): level held while the note is down
+ * - "release" (float, s): time to fall 60 dB after the note is up
+ * - "gain" (float): output gain at full velocity
+ * - "spread" (float): stereo spread by note, 0 (center) to 1
+ *
+ * Outputs: "left" and "right" (Audio).
+ */
+class PolySynthNode : public Node {
+public:
+  /** Index of the "waveform" parameter. */
+  static constexpr size_t kWaveform = 0;
+
+  /** Index of the "cutoff" parameter. */
+  static constexpr size_t kCutoff = 1;
+
+  /** Index of the "q" parameter. */
+  static constexpr size_t kQ = 2;
+
+  /** Index of the "keytrack" parameter. */
+  static constexpr size_t kKeyTrack = 3;
+
+  /** Index of the "attack" parameter. */
+  static constexpr size_t kAttack = 4;
+
+  /** Index of the "decay" parameter. */
+  static constexpr size_t kDecay = 5;
+
+  /** Index of the "sustain" parameter. */
+  static constexpr size_t kSustain = 6;
+
+  /** Index of the "release" parameter. */
+  static constexpr size_t kRelease = 7;
+
+  /** Index of the "gain" parameter. */
+  static constexpr size_t kGain = 8;
+
+  /** Index of the "spread" parameter. */
+  static constexpr size_t kSpread = 9;
+
+  /**
+   * @brief Constructs a PolySynthNode.
+   * @param id The unique identifier of the Node.
+   * @param numVoices The maximum number of simultaneous notes.
+   * @param stealing The policy used when all voices are in use.
+   */
+  PolySynthNode(const std::string &id, int numVoices = 64,
+                VoicePool::Stealing stealing = VoicePool::Stealing::Oldest);
+
+  /**
+   * @brief Returns the voice allocator.
+   * @return The pool; read it on the audio thread only while running.
+   */
+  const VoicePool &getVoicePool() const { return pool_; }
+
+  void process(const ProcessContext &ctx) override;
+
+protected:
+  void onPrepare(double sampleRate, int blockSize) override;
+  void onEvent(const RtEvent &event) override;
+
+private:
+  /** Puts a voice into the idle state that free lanes are rendered with. */
+  void resetVoice(int voice);
+
+  /** Sets up a voice for a new note. */
+  void startVoice(int voice, int note, float velocity);
+
+  /** Computes a voice's filter coefficients from the parameters. */
+  void designFilter(int voice);
+
+  /** Computes a voice's output gains from the parameters. */
+  void updateGains(int voice);
+
+  /** Rebuilds groups_ from the active voices. */
+  void updateGroups();
+
+  /** Reads the parameters and refreshes what depends on them. */
+  void applyParams();
+
+  /** Frees released voices that have faded out. */
+  void freeSilentVoices();
+
+  /** The voice allocator. */
+  VoicePool pool_;
+
+  /** Number of voices rounded up to whole groups. */
+  int numLanes_ = 0;
+
+  /** Backing store of every array of bank_. */
+  std::vector<float> storage_;
+
+  /** The voice state, pointing into storage_. */
+  dsp::VoiceBank bank_{};
+
+  /** Velocity of each voice's note. */
+  std::vector<float> velocities_;
+
+  /** Indices of the groups holding active voices. */
+  std::vector<int> groups_;
+
+  /** Number of valid entries in groups_. */
+  int numGroups_ = 0;
+
+  /** Envelope rates derived from the parameters. */
+  float attackRate_ = 1.0f;
+  float releaseRate_ = 1.0f;
+
+  /** Parameter values the filters and gains were computed from. */
+  float designedCutoff_ = -1.0f;
+  float designedQ_ = -1.0f;
+  float designedKeyTrack_ = -1.0f;
+  float appliedGain_ = -1.0f;
+  float appliedSpread_ = -1.0f;
+};
+
+} // namespace ms
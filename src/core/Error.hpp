@@ -0,0 +1,25 @@
+#pragma once
+#include <string>
+
+/**
+ * @file Error.hpp
+ * @brief Reporting of failures through an optional message argument.
+ *
+ * Private to the library.
+ */
+
+namespace ms {
+
+/**
+ * Stores a description of a failure for a caller that asked for one.
+ *
+ * @param error The caller's `std::string *error` argument; may be nullptr.
+ * @param message The description.
+ */
+inline void setError(std::string *error, const std::string &message) {
+  if (error) {
+    *error = message;
+  }
+}
+
+} // namespace ms
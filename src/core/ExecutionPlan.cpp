@@ -0,0 +1,480 @@
+#include "core/ExecutionPlan.hpp"
+#include "Error.hpp"
+#include "core/WorkerPool.hpp"
+#include "dsp/Kernels.hpp"
+#include <algorithm>
+#include <unordered_map>
+
+namespace ms {
+
+namespace {
+
+/** A Connection with names resolved to node and port indices. */
+struct Edge {
+  size_t source;
+  int sourcePort;
+  size_t dest;
+  int destPort;
+};
+
+} // namespace
+
+std::unique_ptr<ExecutionPlan>
+ExecutionPlan::compile(const Graph &graph, const CompileOptions &options,
+                       std::string *error) {
+  if (options.blockSize <= 0 || options.sampleRate <= 0.0) {
+    setError(error, "invalid sample rate or block size");
+    return nullptr;
+  }
+  // Nodes fetch the kernels in process(); select them here, off the audio
+  // thread.
+  dsp::initKernels();
+
+  const auto &nodes = graph.getNodes();
+  std::unordered_map<std::string, size_t> indexOf;
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    indexOf[nodes[i]->getId()] = i;
+  }
+
+  std::vector<Edge> edges;
+  std::vector<std::vector<size_t>> successors(nodes.size());
+  std::vector<std::vector<size_t>> predecessors(nodes.size());
+  std::vector<int> inDegree(nodes.size(), 0);
+  for (const auto &c : graph.getConnections()) {
+    Edge edge{indexOf.at(c.sourceNode), 0, indexOf.at(c.destNode), 0};
+    edge.sourcePort = nodes[edge.source]->findOutputPort(c.sourcePort);
+    edge.destPort = nodes[edge.dest]->findInputPort(c.destPort);
+    edges.push_back(edge);
+    auto &next = successors[edge.source];
+    if (std::find(next.begin(), next.end(), edge.dest) == next.end()) {
+      next.push_back(edge.dest);
+      predecessors[edge.dest].push_back(edge.source);
+      ++inDegree[edge.dest];
+    }
+  }
+
+  // Kahn's algorithm, depth first: the Node that became ready last runs
+  // next, so a signal is consumed soon after it is produced and few buffers
+  // are live at once. Sources start in insertion order, which keeps the
+  // schedule deterministic for a given graph.
+  std::vector<size_t> order;
+  std::vector<size_t> ready;
+  for (size_t i = nodes.size(); i-- > 0;) {
+    if (inDegree[i] == 0) {
+      ready.push_back(i);
+    }
+  }
+  while (!ready.empty()) {
+    const size_t i = ready.back();
+    ready.pop_back();
+    order.push_back(i);
+    const auto &next = successors[i];
+    for (auto it = next.rbegin(); it != next.rend(); ++it) {
+      if (--inDegree[*it] == 0) {
+        ready.push_back(*it);
+      }
+    }
+  }
+  if (order.size() != nodes.size()) {
+    setError(error, "graph contains a cycle");
+    return nullptr;
+  }
+  for (const auto &node : nodes) {
+    if (!node->canPrepare(options.sampleRate, options.blockSize)) {
+      setError(error, "node '" + node->getId() +
+                          "' is in use by another plan at a different format");
+      return nullptr;
+    }
+  }
+
+  // Group the sorted Nodes into chains. A Node extends the chain of its
+  // predecessor when it is that predecessor's only successor and has no
+  // other input. Concatenating the chains in order of their first Node keeps
+  // the order topological.
+  std::vector<size_t> taskOf(nodes.size());
+  std::vector<std::vector<size_t>> chains;
+  for (size_t i : order) {
+    const auto &pred = predecessors[i];
+    if (pred.size() == 1 && successors[pred[0]].size() == 1) {
+      taskOf[i] = taskOf[pred[0]];
+    } else {
+      taskOf[i] = chains.size();
+      chains.emplace_back();
+    }
+    chains[taskOf[i]].push_back(i);
+  }
+  order.clear();
+  for (const auto &chain : chains) {
+    order.insert(order.end(), chain.begin(), chain.end());
+  }
+
+  std::unique_ptr<ExecutionPlan> plan(new ExecutionPlan());
+  plan->sampleRate_ = options.sampleRate;
+  plan->blockSize_ = options.blockSize;
+  plan->numThreads_ = std::max(1, options.numThreads);
+
+  uint32_t firstStep = 0;
+  for (const auto &chain : chains) {
+    Task task{};
+    task.firstStep = firstStep;
+    task.numSteps = static_cast<uint32_t>(chain.size());
+    task.firstSuccessor = static_cast<uint32_t>(plan->successors_.size());
+    for (size_t next : successors[chain.back()]) {
+      plan->successors_.push_back(static_cast<uint32_t>(taskOf[next]));
+    }
+    task.numSuccessors =
+        static_cast<uint32_t>(plan->successors_.size()) - task.firstSuccessor;
+    task.numPredecessors =
+        static_cast<int32_t>(predecessors[chain.front()].size());
+    if (task.numSuccessors == 0) {
+      ++plan->numSinks_;
+    }
+    plan->tasks_.push_back(task);
+    firstStep += task.numSteps;
+  }
+  plan->pendingPredecessors_.reset(
+      new std::atomic<int32_t>[plan->tasks_.size()]);
+  plan->parallel_ =
+      plan->numThreads_ > 1 && plan->tasks_.size() > 1 &&
+      static_cast<int>(nodes.size()) >= options.parallelThreshold;
+  if (plan->parallel_) {
+    for (int t = 0; t < plan->numThreads_; ++t) {
+      plan->deques_.push_back(
+          std::make_unique<WorkStealingDeque>(plan->tasks_.size()));
+    }
+  }
+
+  // Value numbering: every Audio output port carries one signal per block.
+  std::vector<size_t> stepOf(nodes.size());
+  std::vector<std::vector<int>> valueOf(nodes.size());
+  std::vector<uint32_t> writerOf;
+  for (size_t s = 0; s < order.size(); ++s) {
+    const size_t i = order[s];
+    stepOf[i] = s;
+    const auto &ports = nodes[i]->getOutputPorts();
+    valueOf[i].assign(ports.size(), -1);
+    for (size_t p = 0; p < ports.size(); ++p) {
+      if (ports[p].type == PortType::Audio) {
+        valueOf[i][p] = static_cast<int>(writerOf.size());
+        writerOf.push_back(static_cast<uint32_t>(s));
+      }
+    }
+  }
+  const size_t numValues = writerOf.size();
+  std::vector<std::vector<int>> sourceOf(nodes.size());
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    sourceOf[i].assign(nodes[i]->getInputPorts().size(), -1);
+  }
+  std::vector<std::vector<uint32_t>> readersOf(numValues);
+  for (const auto &edge : edges) {
+    const int value = valueOf[edge.source][edge.sourcePort];
+    if (value >= 0) {
+      sourceOf[edge.dest][edge.destPort] = value;
+      readersOf[value].push_back(static_cast<uint32_t>(stepOf[edge.dest]));
+    }
+  }
+  std::vector<bool> isGraphOutput(numValues, false);
+  for (const auto &output : graph.getOutputs()) {
+    const size_t i = indexOf.at(output.node);
+    isGraphOutput[valueOf[i][nodes[i]->findOutputPort(output.port)]] = true;
+  }
+
+  // happensBefore(a, b): step a is guaranteed to finish before step b starts.
+  // Serially that is plain program order; in parallel it takes an earlier
+  // step of the same task or a step of an ancestor task.
+  std::vector<uint32_t> taskOfStep(order.size());
+  for (size_t s = 0; s < order.size(); ++s) {
+    taskOfStep[s] = static_cast<uint32_t>(taskOf[order[s]]);
+  }
+  const size_t words = (plan->tasks_.size() + 63) / 64;
+  std::vector<uint64_t> ancestors;
+  if (plan->parallel_) {
+    ancestors.assign(plan->tasks_.size() * words, 0);
+    for (size_t t = 0; t < plan->tasks_.size(); ++t) {
+      const Task &task = plan->tasks_[t];
+      for (uint32_t k = 0; k < task.numSuccessors; ++k) {
+        const uint32_t next = plan->successors_[task.firstSuccessor + k];
+        for (size_t w = 0; w < words; ++w) {
+          ancestors[next * words + w] |= ancestors[t * words + w];
+        }
+        ancestors[next * words + t / 64] |= uint64_t(1) << (t % 64);
+      }
+    }
+  }
+  auto happensBefore = [&](uint32_t a, uint32_t b) {
+    if (a >= b) {
+      return false;
+    }
+    if (!plan->parallel_) {
+      return true;
+    }
+    const uint32_t ta = taskOfStep[a];
+    const uint32_t tb = taskOfStep[b];
+    return ta == tb || (ancestors[tb * words + ta / 64] >> (ta % 64)) & 1;
+  };
+
+  // Linear-scan allocation in step order. A freed buffer remembers every
+  // step that touched its last signal; it can only be reused by a step that
+  // runs after all of them.
+  struct FreeBuffer {
+    int buffer;
+    std::vector<uint32_t> users;
+  };
+  std::vector<FreeBuffer> freeList;
+  std::vector<int> bufferOfValue(numValues, -1);
+  std::vector<size_t> readsLeft(numValues);
+  std::vector<bool> transferred(numValues, false);
+  for (size_t v = 0; v < numValues; ++v) {
+    readsLeft[v] = readersOf[v].size();
+  }
+  auto release = [&](int value) {
+    FreeBuffer entry{bufferOfValue[value], readersOf[value]};
+    entry.users.push_back(writerOf[value]);
+    freeList.push_back(std::move(entry));
+  };
+  int numBuffers = 1;
+  for (size_t s = 0; s < order.size(); ++s) {
+    const size_t i = order[s];
+    const auto &ports = nodes[i]->getOutputPorts();
+    const auto &sources = sourceOf[i];
+    for (size_t p = 0; p < ports.size(); ++p) {
+      const int value = valueOf[i][p];
+      if (value < 0) {
+        continue;
+      }
+      const int in = ports[p].inPlaceInput;
+      const int source =
+          in >= 0 && in < static_cast<int>(sources.size()) ? sources[in] : -1;
+      // In place only if this port is the last reader of the signal and
+      // every other reader is done with it before this step runs.
+      bool inPlace = source >= 0 && !isGraphOutput[source] &&
+                     !transferred[source] && readsLeft[source] == 1 &&
+                     std::count(sources.begin(), sources.end(), source) == 1;
+      if (inPlace) {
+        for (uint32_t reader : readersOf[source]) {
+          inPlace = inPlace && (reader == s || happensBefore(reader, s));
+        }
+      }
+      if (inPlace) {
+        bufferOfValue[value] = bufferOfValue[source];
+        transferred[source] = true;
+        ++plan->bufferStats_.numInPlace;
+        continue;
+      }
+      // Most recently freed first: that buffer is the likeliest to be hot.
+      auto reusable = std::find_if(
+          freeList.rbegin(), freeList.rend(), [&](const FreeBuffer &entry) {
+            return std::all_of(
+                entry.users.begin(), entry.users.end(),
+                [&](uint32_t user) { return happensBefore(user, s); });
+          });
+      if (reusable != freeList.rend()) {
+        bufferOfValue[value] = reusable->buffer;
+        freeList.erase(std::next(reusable).base());
+      } else {
+        bufferOfValue[value] = numBuffers++;
+      }
+    }
+    for (int source : sources) {
+      if (source >= 0 && --readsLeft[source] == 0 && !transferred[source] &&
+          !isGraphOutput[source]) {
+        release(source);
+      }
+    }
+    for (int value : valueOf[i]) {
+      if (value >= 0 && readersOf[value].empty() && !isGraphOutput[value]) {
+        release(value);
+      }
+    }
+  }
+  plan->buffers_ =
+      std::make_unique<BufferPool>(numBuffers, options.blockSize);
+  plan->bufferStats_.numAudioOutputs = numValues;
+  plan->bufferStats_.peakBuffers = static_cast<size_t>(numBuffers) - 1;
+  plan->bufferStats_.bytes = plan->buffers_->getBytes();
+
+  std::vector<size_t> inputOffset(nodes.size());
+  std::vector<size_t> outputOffset(nodes.size());
+  size_t numInputs = 0;
+  size_t numOutputs = 0;
+  for (size_t i : order) {
+    inputOffset[i] = numInputs;
+    outputOffset[i] = numOutputs;
+    numInputs += nodes[i]->getInputPorts().size();
+    numOutputs += nodes[i]->getOutputPorts().size();
+  }
+  const BufferPool &pool = *plan->buffers_;
+  plan->inputPointers_.assign(numInputs, nullptr);
+  plan->outputPointers_.assign(numOutputs, nullptr);
+  for (size_t i : order) {
+    const auto &inputs = nodes[i]->getInputPorts();
+    for (size_t p = 0; p < inputs.size(); ++p) {
+      if (inputs[p].type == PortType::Audio) {
+        const int source = sourceOf[i][p];
+        plan->inputPointers_[inputOffset[i] + p] = pool.getBuffer(
+            source >= 0 ? static_cast<size_t>(bufferOfValue[source]) : 0);
+      }
+    }
+    for (size_t p = 0; p < valueOf[i].size(); ++p) {
+      if (valueOf[i][p] >= 0) {
+        plan->outputPointers_[outputOffset[i] + p] =
+            pool.getBuffer(bufferOfValue[valueOf[i][p]]);
+      }
+    }
+  }
+
+  plan->physicalInputs_.assign(
+      static_cast<size_t>(std::max(0, options.numPhysicalInputs)),
+      pool.getBuffer(0));
+  for (size_t i : order) {
+    nodes[i]->prepare(options.sampleRate, options.blockSize);
+    nodes[i]->numPlans_.fetch_add(1, std::memory_order_acq_rel);
+    plan->nodes_.push_back(nodes[i]);
+    ProcessContext context{plan->inputPointers_.data() + inputOffset[i],
+                           plan->outputPointers_.data() + outputOffset[i],
+                           options.blockSize};
+    context.physicalInputs = plan->physicalInputs_.data();
+    context.numPhysicalInputs = plan->getNumPhysicalInputs();
+    plan->steps_.push_back({nodes[i].get(), context, nullptr, 0});
+  }
+
+  uint32_t maxHandle = 0;
+  for (const auto &node : nodes) {
+    maxHandle = std::max(maxHandle, node->getHandle());
+  }
+  plan->stepOfHandle_.assign(nodes.empty() ? 0 : maxHandle + 1, -1);
+  for (size_t s = 0; s < order.size(); ++s) {
+    plan->stepOfHandle_[nodes[order[s]]->getHandle()] = static_cast<int32_t>(s);
+  }
+  const size_t maxEvents =
+      static_cast<size_t>(std::max(0, options.maxEventsPerBlock));
+  plan->incoming_.resize(maxEvents);
+  plan->events_.resize(maxEvents);
+  plan->eventStarts_.assign(order.size() + 1, 0);
+  plan->paramEventCounts_.assign(order.size(), 0);
+
+  for (const auto &output : graph.getOutputs()) {
+    const size_t i = indexOf.at(output.node);
+    const int value = valueOf[i][nodes[i]->findOutputPort(output.port)];
+    plan->outputs_.push_back(pool.getBuffer(bufferOfValue[value]));
+  }
+
+  return plan;
+}
+
+ExecutionPlan::~ExecutionPlan() {
+  for (const auto &node : nodes_) {
+    node->numPlans_.fetch_sub(1, std::memory_order_acq_rel);
+  }
+}
+
+void ExecutionPlan::process(Profiler *profiler) {
+  profiler_ = Profiler::isCompiledIn() ? profiler : nullptr;
+  dispatchEvents();
+  runSerial();
+}
+
+void ExecutionPlan::process(WorkerPool &pool, Profiler *profiler) {
+  // Workers read profiler_ after pool.run() has published the plan.
+  profiler_ = Profiler::isCompiledIn() ? profiler : nullptr;
+  dispatchEvents();
+  if (parallel_) {
+    pool.run(*this);
+  } else {
+    runSerial();
+  }
+}
+
+void ExecutionPlan::runSerial() {
+  Profiler *const profiler = Profiler::isCompiledIn() ? profiler_ : nullptr;
+  if (profiler) {
+    uint64_t time = Profiler::now();
+    for (const Step &step : steps_) {
+      time = runStep(step, *profiler, 0, time);
+    }
+    return;
+  }
+  for (const Step &step : steps_) {
+    runStep(step);
+  }
+}
+
+bool ExecutionPlan::postEvent(const RtEvent &event) {
+  if (!canPostEvent()) {
+    return false;
+  }
+  if (event.target < stepOfHandle_.size() &&
+      stepOfHandle_[event.target] >= 0) {
+    RtEvent &slot = incoming_[numIncoming_++];
+    slot = event;
+    slot.sampleOffset = std::min(std::max(event.sampleOffset, 0),
+                                 blockSize_ - 1);
+  }
+  return true;
+}
+
+void ExecutionPlan::dispatchEvents() {
+  if (numIncoming_ == 0 && !hadEvents_) {
+    return;
+  }
+  // Counting sort by step keeps arrival order within a step; an insertion
+  // sort then orders by offset without disturbing equal offsets. Each step's
+  // range holds its parameter changes first and its other events after.
+  const size_t numSteps = steps_.size();
+  std::fill(eventStarts_.begin(), eventStarts_.end(), 0);
+  std::fill(paramEventCounts_.begin(), paramEventCounts_.end(), 0);
+  for (size_t e = 0; e < numIncoming_; ++e) {
+    const int32_t s = stepOfHandle_[incoming_[e].target];
+    ++eventStarts_[s + 1];
+    if (incoming_[e].type == EventTypes::ParamChange) {
+      ++paramEventCounts_[s];
+    }
+  }
+  for (size_t s = 0; s < numSteps; ++s) {
+    eventStarts_[s + 1] += eventStarts_[s];
+  }
+  for (size_t s = 0; s < numSteps; ++s) {
+    Step &step = steps_[s];
+    step.paramEvents = events_.data() + eventStarts_[s];
+    step.numParamEvents = 0;
+    step.context.events = step.paramEvents + paramEventCounts_[s];
+    step.context.numEvents = 0;
+  }
+  for (size_t e = 0; e < numIncoming_; ++e) {
+    const RtEvent &event = incoming_[e];
+    const int32_t s = stepOfHandle_[event.target];
+    Step &step = steps_[s];
+    const bool isParam = event.type == EventTypes::ParamChange;
+    RtEvent *events =
+        events_.data() + eventStarts_[s] + (isParam ? 0 : paramEventCounts_[s]);
+    int i = isParam ? step.numParamEvents++ : step.context.numEvents++;
+    while (i > 0 && events[i - 1].sampleOffset > event.sampleOffset) {
+      events[i] = events[i - 1];
+      --i;
+    }
+    events[i] = event;
+  }
+  hadEvents_ = numIncoming_ > 0;
+  numIncoming_ = 0;
+}
+
+void ExecutionPlan::setPhysicalInputs(const float *const *channels,
+                                      int numChannels) {
+  const float *silence = buffers_->getBuffer(0);
+  for (size_t c = 0; c < physicalInputs_.size(); ++c) {
+    const float *channel =
+        static_cast<int>(c) < numChannels ? channels[c] : nullptr;
+    physicalInputs_[c] = channel ? channel : silence;
+  }
+}
+
+int ExecutionPlan::findNode(const std::string &id) const {
+  for (size_t i = 0; i < nodes_.size(); ++i) {
+    if (nodes_[i]->getId() == id) {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
+} // namespace ms
@@ -0,0 +1,99 @@
+#include "core/Graph.hpp"
+#include <algorithm>
+
+namespace ms {
+
+bool Graph::addNode(std::shared_ptr<Node> node) {
+  if (!node || getNode(node->getId())) {
+    return false;
+  }
+  nodes_.push_back(std::move(node));
+  return true;
+}
+
+bool Graph::removeNode(const std::string &id) {
+  auto it = std::find_if(nodes_.begin(), nodes_.end(),
+                         [&](const auto &node) { return node->getId() == id; });
+  if (it == nodes_.end()) {
+    return false;
+  }
+  nodes_.erase(it);
+  connections_.erase(std::remove_if(connections_.begin(), connections_.end(),
+                                    [&](const Connection &c) {
+                                      return c.sourceNode == id ||
+                                             c.destNode == id;
+                                    }),
+                     connections_.end());
+  outputs_.erase(
+      std::remove_if(outputs_.begin(), outputs_.end(),
+                     [&](const GraphOutput &o) { return o.node == id; }),
+      outputs_.end());
+  return true;
+}
+
+std::shared_ptr<Node> Graph::getNode(const std::string &id) const {
+  for (const auto &node : nodes_) {
+    if (node->getId() == id) {
+      return node;
+    }
+  }
+  return nullptr;
+}
+
+bool Graph::connect(const std::string &sourceNode,
+                    const std::string &sourcePort, const std::string &destNode,
+                    const std::string &destPort) {
+  auto source = getNode(sourceNode);
+  auto dest = getNode(destNode);
+  if (!source || !dest) {
+    return false;
+  }
+  const int out = source->findOutputPort(sourcePort);
+  const int in = dest->findInputPort(destPort);
+  if (out < 0 || in < 0) {
+    return false;
+  }
+  if (source->getOutputPorts()[out].type != dest->getInputPorts()[in].type) {
+    return false;
+  }
+  for (const auto &c : connections_) {
+    if (c.destNode == destNode && c.destPort == destPort) {
+      return false;
+    }
+  }
+  connections_.push_back({sourceNode, sourcePort, destNode, destPort});
+  return true;
+}
+
+bool Graph::disconnect(const std::string &sourceNode,
+                       const std::string &sourcePort,
+                       const std::string &destNode,
+                       const std::string &destPort) {
+  auto it = std::find_if(connections_.begin(), connections_.end(),
+                         [&](const Connection &c) {
+                           return c.sourceNode == sourceNode &&
+                                  c.sourcePort == sourcePort &&
+                                  c.destNode == destNode &&
+                                  c.destPort == destPort;
+                         });
+  if (it == connections_.end()) {
+    return false;
+  }
+  connections_.erase(it);
+  return true;
+}
+
+bool Graph::addOutput(const std::string &node, const std::string &port) {
+  auto n = getNode(node);
+  if (!n) {
+    return false;
+  }
+  const int out = n->findOutputPort(port);
+  if (out < 0 || n->getOutputPorts()[out].type != PortType::Audio) {
+    return false;
+  }
+  outputs_.push_back({node, port});
+  return true;
+}
+
+} // namespace ms
@@ -0,0 +1,127 @@
+#include "core/GraphEngine.hpp"
+
+namespace ms {
+
+GraphEngine::GraphEngine() : retired_(kRetiredCapacity) {
+  defaultQueue_ = openEventQueue(4096);
+}
+
+GraphEngine::~GraphEngine() { clear(); }
+
+bool GraphEngine::commit(const Graph &graph, const CompileOptions &options,
+                         std::string *error) {
+  auto plan = ExecutionPlan::compile(graph, options, error);
+  if (!plan) {
+    return false;
+  }
+  commit(std::move(plan));
+  return true;
+}
+
+void GraphEngine::commit(std::unique_ptr<ExecutionPlan> plan) {
+  if (plan->isParallel()) {
+    pool_.ensureWorkers(plan->getNumThreads() - 1);
+  }
+  profiler_.registerNodes(*plan);
+  // Whoever takes a plan out of pending_ owns it, so a plan that the audio
+  // thread has not picked up yet can be destroyed right here.
+  delete pending_.exchange(plan.release(), std::memory_order_acq_rel);
+  collectGarbage();
+}
+
+std::shared_ptr<EventQueue> GraphEngine::openEventQueue(size_t capacity) {
+  if (ownedQueues_.size() >= kMaxEventQueues) {
+    return nullptr;
+  }
+  auto queue = std::make_shared<EventQueue>(capacity);
+  queues_[ownedQueues_.size()].store(queue.get(), std::memory_order_release);
+  ownedQueues_.push_back(queue);
+  return queue;
+}
+
+bool GraphEngine::sendParam(const Node &node, const std::string &param,
+                            const ControlValue &value, int sampleOffset,
+                            float rampSeconds) {
+  RtEvent event;
+  const int index = node.findParam(param);
+  if (index < 0 || !toRtValue(value, event.value) ||
+      std::holds_alternative<std::string>(node.getParams()[index].value)) {
+    return false;
+  }
+  event.type = EventTypes::ParamChange;
+  event.target = node.getHandle();
+  event.param = static_cast<uint32_t>(index);
+  event.sampleOffset = sampleOffset;
+  event.data = rampSeconds;
+  return sendEvent(event);
+}
+
+bool GraphEngine::sendEvent(const Node &node, const Event &event) {
+  RtEvent rt;
+  rt.type = internEventType(event.type);
+  if (rt.type == EventTypes::ParamChange || !toRtValue(event.value, rt.value)) {
+    return false;
+  }
+  rt.target = node.getHandle();
+  rt.sampleOffset = event.sampleOffset;
+  if (rt.type == EventTypes::NoteOn) {
+    rt.data = 1.0f;
+  }
+  return sendEvent(rt);
+}
+
+void GraphEngine::collectGarbage() {
+  ExecutionPlan *plan = nullptr;
+  while (retired_.pop(plan)) {
+    delete plan;
+  }
+}
+
+void GraphEngine::clear() {
+  collectGarbage();
+  delete pending_.exchange(nullptr);
+  delete current_;
+  current_ = nullptr;
+}
+
+bool GraphEngine::process(const float *const *physicalInputs,
+                          int numPhysicalInputs, int blockSize) {
+  // Only swap when the old plan can be handed back; otherwise keep running
+  // the current one and try again next block.
+  if (pending_.load(std::memory_order_relaxed) && !retired_.full()) {
+    ExecutionPlan *next = pending_.exchange(nullptr, std::memory_order_acq_rel);
+    if (next) {
+      if (current_) {
+        retired_.push(current_);
+      }
+      current_ = next;
+    }
+  }
+  if (!current_ ||
+      (blockSize > 0 && current_->getBlockSize() != blockSize)) {
+    return false;
+  }
+#if MS_PROFILING
+  const uint64_t blockStart = profiler_.beginBlock();
+#endif
+  for (auto &slot : queues_) {
+    EventQueue *queue = slot.load(std::memory_order_acquire);
+    if (!queue) {
+      break;
+    }
+    RtEvent event;
+    while (current_->canPostEvent() && queue->pop(event)) {
+      current_->postEvent(event);
+    }
+  }
+  current_->setPhysicalInputs(physicalInputs, numPhysicalInputs);
+  current_->process(pool_,
+                    profiler_.isCollecting() ? &profiler_ : nullptr);
+#if MS_PROFILING
+  profiler_.endBlock(blockStart, current_->getBlockSize() /
+                                     current_->getSampleRate());
+#endif
+  return true;
+}
+
+} // namespace ms
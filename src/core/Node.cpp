@@ -0,0 +1,136 @@
+#include "core/Node.hpp"
+#include <cstdio>
+
+namespace ms {
+
+namespace {
+
+/** Reports a parameter change refused because the Node is in a plan. */
+void reportInPlan(const std::string &id, const char *what) {
+  std::fprintf(stderr,
+               "ms::Node::%s: node '%s' is in a plan; use "
+               "GraphEngine::sendParam()\n",
+               what, id.c_str());
+}
+
+} // namespace
+
+const std::vector<Param> &Node::getParams() const {
+  for (size_t i = 0; i < reported_.size(); ++i) {
+    ControlValue &value = reported_[i].value;
+    const float current = values_[i].load(std::memory_order_relaxed);
+    if (std::holds_alternative<float>(value)) {
+      value = current;
+    } else if (std::holds_alternative<int>(value)) {
+      value = static_cast<int>(current);
+    } else if (std::holds_alternative<bool>(value)) {
+      value = current != 0.0f;
+    }
+  }
+  return reported_;
+}
+
+bool Node::setParams(const std::vector<Param> &newParams) {
+  if (isInPlan()) {
+    reportInPlan(id_, "setParams");
+    return false;
+  }
+  params_ = newParams;
+  reported_ = newParams;
+  values_ = std::vector<std::atomic<float>>(params_.size());
+  for (size_t i = 0; i < params_.size(); ++i) {
+    values_[i].store(toFloat(params_[i].value), std::memory_order_relaxed);
+  }
+  return true;
+}
+
+bool Node::setParam(const std::string &name, const ControlValue &value) {
+  if (isInPlan()) {
+    reportInPlan(id_, "setParam");
+    return false;
+  }
+  const int index = findParam(name);
+  if (index < 0) {
+    return false;
+  }
+  params_[index].value = value;
+  reported_[index].value = value;
+  values_[index].store(toFloat(value), std::memory_order_relaxed);
+  return true;
+}
+
+const float *Node::getPhysicalInput(int channelIndex) const {
+  if (!context_ || channelIndex < 0 ||
+      channelIndex >= context_->numPhysicalInputs) {
+    return nullptr;
+  }
+  return context_->physicalInputs[channelIndex];
+}
+
+void Node::prepareParams() {
+  const size_t count = params_.size();
+  smoothers_.assign(count, ParamSmoother());
+  for (size_t i = 0; i < count; ++i) {
+    smoothers_[i].configure(params_[i].smoothing, sampleRate_);
+    smoothers_[i].reset(getParamValue(i));
+  }
+  paramStorage_ = std::make_unique<BufferPool>(count, blockSize_);
+  paramBuffers_.assign(count, nullptr);
+  paramCursors_.assign(count, 0);
+  hasParamBuffers_ = false;
+}
+
+void Node::renderParams(const RtEvent *events, int numEvents,
+                        int numFrames) {
+  const size_t count = smoothers_.size();
+  for (size_t i = 0; i < count; ++i) {
+    paramBuffers_[i] = nullptr;
+    paramCursors_[i] = 0;
+  }
+
+  for (int e = 0; e < numEvents; ++e) {
+    const RtEvent &event = events[e];
+    const size_t index = event.param;
+    if (index >= count) {
+      continue;
+    }
+    if (!std::holds_alternative<float>(params_[index].value)) {
+      // Discrete parameters take effect for the whole block.
+      setParamValue(index, event.value);
+      continue;
+    }
+    ParamSmoother &smoother = smoothers_[index];
+    const int offset = event.sampleOffset;
+    if (!paramBuffers_[index] && offset == 0) {
+      // A change at the block start needs no buffer unless it ramps; the
+      // loop below allocates one in that case.
+      smoother.setTarget(event.value.asFloat(), event.data);
+      values_[index].store(smoother.getValue(), std::memory_order_relaxed);
+      continue;
+    }
+    if (!paramBuffers_[index]) {
+      paramBuffers_[index] = paramStorage_->getBuffer(index);
+    }
+    smoother.render(paramBuffers_[index] + paramCursors_[index],
+                    offset - paramCursors_[index]);
+    paramCursors_[index] = offset;
+    smoother.setTarget(event.value.asFloat(), event.data);
+  }
+
+  hasParamBuffers_ = false;
+  for (size_t i = 0; i < count; ++i) {
+    ParamSmoother &smoother = smoothers_[i];
+    if (!paramBuffers_[i] && smoother.isMoving()) {
+      paramBuffers_[i] = paramStorage_->getBuffer(i);
+    }
+    if (!paramBuffers_[i]) {
+      continue;
+    }
+    smoother.render(paramBuffers_[i] + paramCursors_[i],
+                    numFrames - paramCursors_[i]);
+    values_[i].store(smoother.getValue(), std::memory_order_relaxed);
+    hasParamBuffers_ = true;
+  }
+}
+
+} // namespace ms
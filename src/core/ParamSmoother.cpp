@@ -0,0 +1,78 @@
+#include "core/ParamSmoother.hpp"
+#include "dsp/Kernels.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace ms {
+
+namespace {
+
+/** A one-pole ramp ends once it is this close to its target, relatively. */
+constexpr float kOnePoleEpsilon = 1e-5f;
+
+} // namespace
+
+void ParamSmoother::setTarget(float target, float rampSeconds) {
+  Smoothing::Mode mode = smoothing_.mode;
+  float time = smoothing_.time;
+  if (rampSeconds > 0.0f) {
+    mode = Smoothing::Mode::Linear;
+    time = rampSeconds;
+  } else if (rampSeconds < 0.0f) {
+    mode = Smoothing::Mode::None;
+  }
+  const int frames = static_cast<int>(time * sampleRate_ + 0.5);
+  if (mode == Smoothing::Mode::None || frames <= 0 || target == value_) {
+    reset(target);
+    return;
+  }
+
+  target_ = target;
+  if (mode == Smoothing::Mode::Exponential && value_ * target > 0.0f) {
+    shape_ = Shape::Geometric;
+    offset_ = 0.0f;
+    step_ = static_cast<float>(std::pow(target / value_, 1.0 / frames));
+    remaining_ = frames;
+  } else if (mode == Smoothing::Mode::OnePole) {
+    // y[n] = target + (y[0] - target) * r^n; stop once the remaining
+    // distance is negligible.
+    const double r = std::exp(-1.0 / (time * sampleRate_));
+    const double distance = std::fabs(value_ - target);
+    const double epsilon =
+        kOnePoleEpsilon * std::max(1.0, std::fabs(static_cast<double>(target)));
+    shape_ = Shape::Geometric;
+    offset_ = target;
+    step_ = static_cast<float>(r);
+    remaining_ = std::max(
+        1, static_cast<int>(std::ceil(std::log(epsilon / distance) /
+                                      std::log(r))));
+  } else {
+    shape_ = Shape::Linear;
+    step_ = (target - value_) / static_cast<float>(frames);
+    remaining_ = frames;
+  }
+}
+
+void ParamSmoother::render(float *out, int numFrames) {
+  const dsp::Kernels &k = dsp::kernels();
+  const int moving = std::min(numFrames, remaining_);
+  if (moving > 0) {
+    if (shape_ == Shape::Linear) {
+      k.fillLinear(out, moving, value_, step_);
+      value_ += step_ * static_cast<float>(moving);
+    } else {
+      const float scale = value_ - offset_;
+      k.fillGeometric(out, moving, offset_, scale, step_);
+      value_ = offset_ + scale * std::pow(step_, static_cast<float>(moving));
+    }
+    remaining_ -= moving;
+    if (remaining_ == 0) {
+      value_ = target_;
+    }
+  }
+  if (moving < numFrames) {
+    k.fillLinear(out + moving, numFrames - moving, value_, 0.0f);
+  }
+}
+
+} // namespace ms
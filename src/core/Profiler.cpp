@@ -0,0 +1,392 @@
+#include "core/Profiler.hpp"
+#include "Error.hpp"
+#include "core/ExecutionPlan.hpp"
+#include <algorithm>
+#include <cstdio>
+
+namespace ms {
+
+namespace {
+
+double calibrateTicksPerSecond() {
+#if defined(MS_PROFILER_TSC)
+  // The invariant TSC of current x86 CPUs runs at a fixed rate; measure it
+  // against steady_clock over a short interval.
+  using Clock = std::chrono::steady_clock;
+  const Clock::time_point wallStart = Clock::now();
+  const uint64_t tscStart = Profiler::now();
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  const uint64_t tscEnd = Profiler::now();
+  const double seconds =
+      std::chrono::duration<double>(Clock::now() - wallStart).count();
+  return static_cast<double>(tscEnd - tscStart) / seconds;
+#else
+  using Period = std::chrono::steady_clock::period;
+  return static_cast<double>(Period::den) / static_cast<double>(Period::num);
+#endif
+}
+
+/** Increments a counter that only the calling thread writes. */
+void bump(std::atomic<uint64_t> &counter, uint64_t amount = 1) {
+  counter.store(counter.load(std::memory_order_relaxed) + amount,
+                std::memory_order_relaxed);
+}
+
+void writeJsonString(std::FILE *file, const std::string &text) {
+  std::fputc('"', file);
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      std::fputc('\\', file);
+      std::fputc(c, file);
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      std::fprintf(file, "\\u%04x", static_cast<unsigned>(c));
+    } else {
+      std::fputc(c, file);
+    }
+  }
+  std::fputc('"', file);
+}
+
+} // namespace
+
+Profiler::Profiler() {
+  // Calibrate here rather than on the audio thread's first block.
+  getTicksPerSecond();
+}
+
+Profiler::~Profiler() { stop(); }
+
+double Profiler::getTicksPerSecond() {
+  static const double ticksPerSecond = calibrateTicksPerSecond();
+  return ticksPerSecond;
+}
+
+bool Profiler::start(const ProfilerOptions &options) {
+  if (!isCompiledIn() || collector_.joinable()) {
+    return false;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Timings pushed after the previous collection ended are stale.
+    Record record;
+    for (auto &ring : ownedRings_) {
+      while (ring->pop(record)) {
+      }
+    }
+    options_ = options;
+    options_.collectIntervalMs = std::max(1, options_.collectIntervalMs);
+    names_ = planNames_;
+    profiles_.clear();
+    openBlocks_.clear();
+    trace_.clear();
+    collecting_.store(true, std::memory_order_relaxed);
+  }
+  collector_ = std::thread(&Profiler::collectLoop, this);
+  return true;
+}
+
+void Profiler::stop() {
+  if (!collector_.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    collecting_.store(false, std::memory_order_relaxed);
+  }
+  wake_.notify_all();
+  collector_.join();
+  std::lock_guard<std::mutex> lock(mutex_);
+  collect();
+}
+
+void Profiler::reset() {
+  resetRequested_.store(true, std::memory_order_relaxed);
+  std::lock_guard<std::mutex> lock(mutex_);
+  names_ = planNames_;
+  profiles_.clear();
+  openBlocks_.clear();
+  trace_.clear();
+}
+
+void Profiler::registerNodes(const ExecutionPlan &plan) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  planNames_.clear();
+  for (const auto &node : plan.getNodes()) {
+    planNames_[node->getHandle()] = node->getId();
+    names_[node->getHandle()] = node->getId();
+  }
+  const size_t numThreads = static_cast<size_t>(
+      std::min(std::max(1, plan.getNumThreads()), kMaxThreads));
+  while (ownedRings_.size() < numThreads) {
+    ownedRings_.push_back(std::make_unique<Ring>(kRingCapacity));
+    rings_[ownedRings_.size() - 1].store(ownedRings_.back().get(),
+                                         std::memory_order_release);
+  }
+}
+
+void Profiler::endBlock(uint64_t start, double periodSeconds) {
+  const uint64_t end = now();
+  if (resetRequested_.load(std::memory_order_relaxed)) {
+    numBlocks_.store(0, std::memory_order_relaxed);
+    numXruns_.store(0, std::memory_order_relaxed);
+    busyTicks_.store(0, std::memory_order_relaxed);
+    periodTicks_.store(0, std::memory_order_relaxed);
+    worstTicks_.store(0, std::memory_order_relaxed);
+    worstLoad_.store(0.0f, std::memory_order_relaxed);
+    for (auto &bucket : histogram_) {
+      bucket.store(0, std::memory_order_relaxed);
+    }
+    resetRequested_.store(false, std::memory_order_relaxed);
+  }
+
+  const uint64_t busy = end - start;
+  const double period =
+      std::max(1.0, periodSeconds * getTicksPerSecond());
+  const float load = static_cast<float>(static_cast<double>(busy) / period);
+  const bool xrun = static_cast<double>(busy) > period;
+
+  bump(numBlocks_);
+  bump(busyTicks_, busy);
+  bump(periodTicks_, static_cast<uint64_t>(period));
+  if (xrun) {
+    bump(numXruns_);
+  }
+  if (busy > worstTicks_.load(std::memory_order_relaxed)) {
+    worstTicks_.store(busy, std::memory_order_relaxed);
+  }
+  if (load > worstLoad_.load(std::memory_order_relaxed)) {
+    worstLoad_.store(load, std::memory_order_relaxed);
+  }
+  lastLoad_.store(load, std::memory_order_relaxed);
+  // Clamped before the conversion: a stalled block has an arbitrarily large
+  // load, and the negated test also sends NaN to the first bucket.
+  const float percent = load * 100.0f;
+  const int bucket =
+      !(percent > 0.0f)
+          ? 0
+          : static_cast<int>(std::min(
+                percent, static_cast<float>(kHistogramBuckets - 1)));
+  bump(histogram_[bucket]);
+
+  if (isCollecting()) {
+    Record record;
+    record.start = start;
+    record.end = end;
+    record.block = block_.load(std::memory_order_relaxed);
+    record.node = xrun ? kXrunRecord : kBlockRecord;
+    record.load = load;
+    push(0, record);
+  }
+}
+
+BlockStats Profiler::getBlockStats() const {
+  BlockStats stats;
+  const double ticksPerSecond = getTicksPerSecond();
+  stats.numBlocks = numBlocks_.load(std::memory_order_relaxed);
+  stats.numXruns = numXruns_.load(std::memory_order_relaxed);
+  const uint64_t period = periodTicks_.load(std::memory_order_relaxed);
+  if (period > 0) {
+    stats.averageLoad =
+        static_cast<double>(busyTicks_.load(std::memory_order_relaxed)) /
+        static_cast<double>(period);
+  }
+  stats.lastLoad = lastLoad_.load(std::memory_order_relaxed);
+  stats.worstLoad = worstLoad_.load(std::memory_order_relaxed);
+  stats.worstBlockSeconds =
+      static_cast<double>(worstTicks_.load(std::memory_order_relaxed)) /
+      ticksPerSecond;
+
+  std::array<uint64_t, kHistogramBuckets> counts;
+  uint64_t total = 0;
+  for (int i = 0; i < kHistogramBuckets; ++i) {
+    counts[i] = histogram_[i].load(std::memory_order_relaxed);
+    total += counts[i];
+  }
+  // Each percentile is reported as the upper edge of its bucket.
+  auto percentile = [&](double fraction) {
+    const double rank = fraction * static_cast<double>(total);
+    uint64_t below = 0;
+    for (int i = 0; i < kHistogramBuckets; ++i) {
+      below += counts[i];
+      if (counts[i] > 0 && static_cast<double>(below) >= rank) {
+        return (i + 1) / 100.0;
+      }
+    }
+    return 0.0;
+  };
+  if (total > 0) {
+    stats.p50Load = percentile(0.5);
+    stats.p90Load = percentile(0.9);
+    stats.p99Load = percentile(0.99);
+    stats.p999Load = percentile(0.999);
+  }
+  return stats;
+}
+
+std::vector<NodeProfile> Profiler::getNodeProfiles() const {
+  std::vector<NodeProfile> profiles;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    profiles.reserve(profiles_.size());
+    for (const auto &entry : profiles_) {
+      profiles.push_back(entry.second);
+    }
+  }
+  std::sort(profiles.begin(), profiles.end(),
+            [](const NodeProfile &a, const NodeProfile &b) {
+              return a.totalSeconds > b.totalSeconds;
+            });
+  return profiles;
+}
+
+void Profiler::collectLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (isCollecting()) {
+    wake_.wait_for(lock, std::chrono::milliseconds(options_.collectIntervalMs),
+                   [&] { return !isCollecting(); });
+    collect();
+  }
+}
+
+void Profiler::collect() {
+  if (ownedRings_.empty()) {
+    return;
+  }
+  // The audio thread pushes a block's record only after every thread has
+  // finished the block, so once it is popped here the block's Node timings
+  // are visible in all rings and the block can be closed below.
+  std::vector<Record> closed;
+  Record record;
+  while (ownedRings_[0]->pop(record)) {
+    if (record.node == kBlockRecord || record.node == kXrunRecord) {
+      closed.push_back(record);
+      if (trace_.size() < options_.maxTraceEvents) {
+        trace_.push_back({record, 0});
+      }
+    } else {
+      accumulate(record, 0);
+    }
+  }
+  for (size_t t = 1; t < ownedRings_.size(); ++t) {
+    while (ownedRings_[t]->pop(record)) {
+      accumulate(record, static_cast<int>(t));
+    }
+  }
+
+  for (const Record &block : closed) {
+    auto slowest = openBlocks_.find(block.block);
+    if (slowest == openBlocks_.end()) {
+      continue;
+    }
+    if (block.node == kXrunRecord) {
+      ++profiles_[slowest->second.node].numXrunsCaused;
+    }
+    openBlocks_.erase(slowest);
+  }
+  if (!closed.empty()) {
+    // Blocks whose record was dropped would otherwise stay open forever.
+    const uint32_t last = closed.back().block;
+    for (auto it = openBlocks_.begin(); it != openBlocks_.end();) {
+      if (static_cast<int32_t>(it->first - last) <= 0) {
+        it = openBlocks_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+}
+
+void Profiler::accumulate(const Record &record, int thread) {
+  const uint64_t ticks = record.end - record.start;
+  const double seconds = static_cast<double>(ticks) / getTicksPerSecond();
+  NodeProfile &profile = profiles_[record.node];
+  if (profile.numCalls == 0) {
+    profile.handle = record.node;
+    auto name = names_.find(record.node);
+    if (name != names_.end()) {
+      profile.id = name->second;
+    }
+  }
+  ++profile.numCalls;
+  profile.totalSeconds += seconds;
+  profile.maxSeconds = std::max(profile.maxSeconds, seconds);
+
+  Slowest &slowest = openBlocks_[record.block];
+  if (ticks >= slowest.ticks) {
+    slowest.node = record.node;
+    slowest.ticks = ticks;
+  }
+  if (trace_.size() < options_.maxTraceEvents) {
+    trace_.push_back({record, thread});
+  }
+}
+
+bool Profiler::writeChromeTrace(const std::string &path,
+                                std::string *error) const {
+  std::FILE *file = std::fopen(path.c_str(), "w");
+  if (!file) {
+    setError(error, "cannot create '" + path + "'");
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  uint64_t origin = 0;
+  int numThreads = 0;
+  if (!trace_.empty()) {
+    origin = trace_.front().record.start;
+    for (const TraceEvent &event : trace_) {
+      origin = std::min(origin, event.record.start);
+      numThreads = std::max(numThreads, event.thread + 1);
+    }
+  }
+  const double microsPerTick = 1e6 / getTicksPerSecond();
+
+  std::fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+  for (int t = 0; t < numThreads; ++t) {
+    std::fprintf(file,
+                 "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                 "\"tid\":%d,\"args\":{\"name\":",
+                 t);
+    writeJsonString(file, t == 0 ? std::string("audio")
+                                 : "worker " + std::to_string(t));
+    std::fprintf(file, "}},\n");
+  }
+  for (const TraceEvent &event : trace_) {
+    const Record &record = event.record;
+    const double ts = static_cast<double>(record.start - origin) * microsPerTick;
+    const double dur =
+        static_cast<double>(record.end - record.start) * microsPerTick;
+    const bool isBlock =
+        record.node == kBlockRecord || record.node == kXrunRecord;
+    std::fprintf(file, "{\"name\":");
+    if (isBlock) {
+      writeJsonString(file, record.node == kXrunRecord ? "xrun" : "block");
+    } else {
+      auto name = names_.find(record.node);
+      writeJsonString(file, name != names_.end()
+                                ? name->second
+                                : "#" + std::to_string(record.node));
+    }
+    std::fprintf(file,
+                 ",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+                 "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"block\":%u",
+                 isBlock ? "engine" : "node", event.thread, ts, dur,
+                 record.block);
+    if (isBlock) {
+      std::fprintf(file, ",\"load\":%.4f", record.load);
+    }
+    std::fprintf(file, "}},\n");
+  }
+  // A trailing comma is not valid JSON, so close with an empty metadata event.
+  std::fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+                     "\"args\":{\"name\":\"MilliSuono\"}}\n]}\n");
+
+  const bool ok = std::ferror(file) == 0;
+  if (std::fclose(file) != 0 || !ok) {
+    setError(error, "cannot write '" + path + "'");
+    return false;
+  }
+  return true;
+}
+
+} // namespace ms
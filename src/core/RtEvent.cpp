@@ -0,0 +1,40 @@
+#include "core/RtEvent.hpp"
+#include <mutex>
+#include <unordered_map>
+
+namespace ms {
+
+EventTypeId internEventType(const std::string &name) {
+  static std::mutex mutex;
+  static std::unordered_map<std::string, EventTypeId> ids = {
+      {"param_change", EventTypes::ParamChange},
+      {"note_on", EventTypes::NoteOn},
+      {"note_off", EventTypes::NoteOff},
+  };
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = ids.find(name);
+  if (it != ids.end()) {
+    return it->second;
+  }
+  const EventTypeId id = static_cast<EventTypeId>(ids.size());
+  ids.emplace(name, id);
+  return id;
+}
+
+bool toRtValue(const ControlValue &value, RtValue &out) {
+  if (auto f = std::get_if<float>(&value)) {
+    out.kind = RtValue::Kind::Float;
+    out.f = *f;
+  } else if (auto i = std::get_if<int>(&value)) {
+    out.kind = RtValue::Kind::Int;
+    out.i = *i;
+  } else if (auto b = std::get_if<bool>(&value)) {
+    out.kind = RtValue::Kind::Bool;
+    out.b = *b;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+} // namespace ms
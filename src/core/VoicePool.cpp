@@ -0,0 +1,96 @@
+#include "core/VoicePool.hpp"
+#include <algorithm>
+
+namespace ms {
+
+VoicePool::VoicePool(int numVoices, Stealing stealing) : stealing_(stealing) {
+  resize(numVoices);
+}
+
+void VoicePool::resize(int numVoices) {
+  const size_t count = static_cast<size_t>(std::max(0, numVoices));
+  states_.assign(count, State::Free);
+  notes_.assign(count, 0);
+  ages_.assign(count, 0);
+  numActive_ = 0;
+}
+
+void VoicePool::clear() {
+  std::fill(states_.begin(), states_.end(), State::Free);
+  numActive_ = 0;
+}
+
+int VoicePool::noteOn(int note, const float *levels) {
+  int voice = -1;
+  if (numActive_ < getNumVoices()) {
+    voice = static_cast<int>(
+        std::find(states_.begin(), states_.end(), State::Free) -
+        states_.begin());
+    ++numActive_;
+  } else if (stealing_ != Stealing::None) {
+    voice = findVictim(State::Released, levels);
+    if (voice < 0) {
+      voice = findVictim(State::Held, levels);
+    }
+    if (voice >= 0) {
+      ++numStolen_;
+    }
+  }
+  if (voice < 0) {
+    return -1;
+  }
+  states_[voice] = State::Held;
+  notes_[voice] = note;
+  ages_[voice] = started_++;
+  return voice;
+}
+
+int VoicePool::noteOff(int note) {
+  int voice = -1;
+  for (int v = 0; v < getNumVoices(); ++v) {
+    if (states_[v] == State::Held && notes_[v] == note &&
+        (voice < 0 || ages_[v] < ages_[voice])) {
+      voice = v;
+    }
+  }
+  if (voice >= 0) {
+    states_[voice] = State::Released;
+  }
+  return voice;
+}
+
+void VoicePool::releaseAll() {
+  for (State &state : states_) {
+    if (state == State::Held) {
+      state = State::Released;
+    }
+  }
+}
+
+void VoicePool::free(int voice) {
+  if (states_[voice] != State::Free) {
+    states_[voice] = State::Free;
+    --numActive_;
+  }
+}
+
+int VoicePool::findVictim(State state, const float *levels) const {
+  int victim = -1;
+  for (int v = 0; v < getNumVoices(); ++v) {
+    if (states_[v] != state) {
+      continue;
+    }
+    if (victim < 0) {
+      victim = v;
+    } else if (stealing_ == Stealing::Quietest && levels) {
+      if (levels[v] < levels[victim]) {
+        victim = v;
+      }
+    } else if (ages_[v] < ages_[victim]) {
+      victim = v;
+    }
+  }
+  return victim;
+}
+
+} // namespace ms
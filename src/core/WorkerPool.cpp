@@ -0,0 +1,166 @@
+#include "core/WorkerPool.hpp"
+#include <algorithm>
+#include <chrono>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) ||            \
+    defined(_M_IX86)
+#include <immintrin.h>
+#define MS_CPU_RELAX() _mm_pause()
+#else
+#define MS_CPU_RELAX() std::this_thread::yield()
+#endif
+
+namespace ms {
+
+namespace {
+
+void pinToCpu(std::thread &thread, unsigned cpu) {
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#else
+  (void)thread;
+  (void)cpu;
+#endif
+}
+
+} // namespace
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_.store(false);
+  }
+  wake_.notify_all();
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+}
+
+void WorkerPool::ensureWorkers(int count) {
+  const unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+  while (getNumWorkers() < count) {
+    const int index = getNumWorkers();
+    threads_.emplace_back(&WorkerPool::workerLoop, this, index);
+    if (cpus > 1) {
+      pinToCpu(threads_.back(), 1 + static_cast<unsigned>(index) % (cpus - 1));
+    }
+  }
+}
+
+void WorkerPool::run(ExecutionPlan &plan) {
+  for (size_t t = 0; t < plan.tasks_.size(); ++t) {
+    plan.pendingPredecessors_[t].store(plan.tasks_[t].numPredecessors,
+                                       std::memory_order_relaxed);
+  }
+  for (size_t t = plan.tasks_.size(); t-- > 0;) {
+    if (plan.tasks_[t].numPredecessors == 0) {
+      plan.deques_[0]->push(static_cast<int32_t>(t));
+    }
+  }
+  sinksRemaining_.store(plan.numSinks_, std::memory_order_relaxed);
+  plan_.store(&plan);
+  epoch_.fetch_add(1);
+  if (sleepingWorkers_.load() > 0) {
+    wake_.notify_all();
+  }
+
+  work(plan, 0);
+
+  // A worker that woke up late either sees plan_ cleared or is counted in
+  // activeWorkers_, so the plan cannot be retired while it is still in use.
+  plan_.store(nullptr);
+  while (activeWorkers_.load() > 0) {
+    MS_CPU_RELAX();
+  }
+}
+
+void WorkerPool::workerLoop(int index) {
+  const int participant = index + 1;
+  uint64_t seen = epoch_.load();
+  while (running_.load(std::memory_order_relaxed)) {
+    int spins = 0;
+    while (epoch_.load(std::memory_order_acquire) == seen &&
+           running_.load(std::memory_order_relaxed)) {
+      if (++spins < kSpinsBeforeSleep) {
+        MS_CPU_RELAX();
+        continue;
+      }
+      // The audio thread notifies without taking the lock, so a wake-up can
+      // be missed; the timeout bounds how long a worker sits out.
+      std::unique_lock<std::mutex> lock(mutex_);
+      sleepingWorkers_.fetch_add(1);
+      wake_.wait_for(lock, std::chrono::milliseconds(1), [&] {
+        return epoch_.load() != seen || !running_.load();
+      });
+      sleepingWorkers_.fetch_sub(1);
+      spins = 0;
+    }
+    seen = epoch_.load();
+
+    activeWorkers_.fetch_add(1);
+    ExecutionPlan *plan = plan_.load();
+    if (plan && participant < static_cast<int>(plan->deques_.size())) {
+      work(*plan, participant);
+    }
+    activeWorkers_.fetch_sub(1);
+  }
+}
+
+void WorkerPool::work(ExecutionPlan &plan, int participant) {
+  const int numParticipants = static_cast<int>(plan.deques_.size());
+  WorkStealingDeque &own = *plan.deques_[participant];
+  int32_t task = 0;
+  while (sinksRemaining_.load(std::memory_order_acquire) > 0) {
+    if (own.pop(task)) {
+      execute(plan, task, participant);
+      continue;
+    }
+    bool stolen = false;
+    for (int i = 1; i < numParticipants && !stolen; ++i) {
+      stolen = plan.deques_[(participant + i) % numParticipants]->steal(task);
+    }
+    if (stolen) {
+      execute(plan, task, participant);
+    } else {
+      MS_CPU_RELAX();
+    }
+  }
+}
+
+void WorkerPool::execute(ExecutionPlan &plan, int32_t task, int participant) {
+  const ExecutionPlan::Task &t = plan.tasks_[task];
+  const ExecutionPlan::Step *step = plan.steps_.data() + t.firstStep;
+  Profiler *const profiler =
+      Profiler::isCompiledIn() ? plan.profiler_ : nullptr;
+  if (profiler) {
+    uint64_t time = Profiler::now();
+    for (uint32_t i = 0; i < t.numSteps; ++i, ++step) {
+      time = ExecutionPlan::runStep(*step, *profiler, participant, time);
+    }
+  } else {
+    for (uint32_t i = 0; i < t.numSteps; ++i, ++step) {
+      ExecutionPlan::runStep(*step);
+    }
+  }
+  if (t.numSuccessors == 0) {
+    sinksRemaining_.fetch_sub(1, std::memory_order_acq_rel);
+    return;
+  }
+  const uint32_t *next = plan.successors_.data() + t.firstSuccessor;
+  for (uint32_t i = 0; i < t.numSuccessors; ++i) {
+    if (plan.pendingPredecessors_[next[i]].fetch_sub(
+            1, std::memory_order_acq_rel) == 1) {
+      plan.deques_[participant]->push(static_cast<int32_t>(next[i]));
+    }
+  }
+}
+
+} // namespace ms
@@ -0,0 +1,59 @@
+#pragma once
+#include "dsp/Kernels.hpp"
+
+/**
+ * @file KernelTables.hpp
+ * @brief Entry points of the per-instruction-set kernel translation units.
+ *
+ * Private to the library. Each function returns nullptr when its
+ * instruction set was not enabled for the translation unit.
+ */
+
+namespace ms {
+namespace dsp {
+
+/** Returns the scalar reference kernels; never nullptr. */
+const Kernels *scalarKernels();
+
+/** Returns the SSE2 kernels, or nullptr if not compiled in. */
+const Kernels *sse2Kernels();
+
+/** Returns the AVX2 kernels, or nullptr if not compiled in. */
+const Kernels *avx2Kernels();
+
+/**
+ * Computes the block state-space matrix of a biquad for the SIMD variants:
+ * `columns[j * lanes + k]` is output k of the response to the j-th unit
+ * input among x1, x2, y1, y2, x[0] ... x[lanes - 1].
+ *
+ * @param coefficients The filter.
+ * @param lanes Outputs per block; columns holds (4 + lanes) * lanes floats.
+ * @param columns Receives the matrix.
+ */
+void biquadResponseColumns(const BiquadCoefficients &coefficients, int lanes,
+                           float *columns);
+
+/**
+ * Fixed-frequency oscillators compute the phase of frame i of a chunk as
+ * `phase + increment * i`, which every lane can evaluate independently, and
+ * restart from the wrapped phase after each chunk to bound the rounding
+ * error. All variants use the same chunking so their phases agree.
+ */
+constexpr int kPhaseChunk = 64;
+
+/**
+ * Returns the phase numFrames after `phase`, wrapped into [0, 1]. Shared by
+ * all variants so chunk boundaries round identically.
+ */
+float advancePhase(float phase, float increment, int numFrames);
+
+/** Odd Taylor coefficients of sin(2 pi x), shared by all variants. */
+constexpr float kSineC1 = 6.283185307f;
+constexpr float kSineC3 = -41.34170224f;
+constexpr float kSineC5 = 81.60524928f;
+constexpr float kSineC7 = -76.70585975f;
+constexpr float kSineC9 = 42.05869394f;
+constexpr float kSineC11 = -15.09464258f;
+
+} // namespace dsp
+} // namespace ms
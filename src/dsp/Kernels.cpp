@@ -0,0 +1,120 @@
+#include "KernelTables.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+namespace ms {
+namespace dsp {
+
+namespace {
+
+bool cpuSupports(SimdLevel level) {
+  switch (level) {
+  case SimdLevel::Scalar:
+    return true;
+#if (defined(__GNUC__) || defined(__clang__)) &&                               \
+    (defined(__x86_64__) || defined(__i386__))
+  case SimdLevel::SSE2:
+    return __builtin_cpu_supports("sse2");
+  case SimdLevel::AVX2:
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  case SimdLevel::SSE2: {
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+  }
+  case SimdLevel::AVX2: {
+    int info[4];
+    __cpuid(info, 1);
+    const bool fma = (info[2] & (1 << 12)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (!fma || !osxsave || (_xgetbv(0) & 0x6) != 0x6) {
+      return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+  }
+#endif
+  default:
+    return false;
+  }
+}
+
+const Kernels *compiledKernels(SimdLevel level) {
+  switch (level) {
+  case SimdLevel::AVX2:
+    return avx2Kernels();
+  case SimdLevel::SSE2:
+    return sse2Kernels();
+  default:
+    return scalarKernels();
+  }
+}
+
+SimdLevel maxLevelFromEnvironment() {
+  const char *value = std::getenv("MS_SIMD");
+  if (value && std::strcmp(value, "scalar") == 0) {
+    return SimdLevel::Scalar;
+  }
+  if (value && std::strcmp(value, "sse2") == 0) {
+    return SimdLevel::SSE2;
+  }
+  return SimdLevel::AVX2;
+}
+
+const Kernels &selectKernels() {
+  const SimdLevel max = maxLevelFromEnvironment();
+  for (SimdLevel level : {SimdLevel::AVX2, SimdLevel::SSE2}) {
+    if (static_cast<int>(level) <= static_cast<int>(max)) {
+      if (const Kernels *table = kernelsFor(level)) {
+        return *table;
+      }
+    }
+  }
+  return *scalarKernels();
+}
+
+/** The table returned by kernels(), nullptr until selectKernels() ran. */
+std::atomic<const Kernels *> selected{nullptr};
+
+} // namespace
+
+const char *simdLevelName(SimdLevel level) {
+  switch (level) {
+  case SimdLevel::SSE2:
+    return "sse2";
+  case SimdLevel::AVX2:
+    return "avx2";
+  default:
+    return "scalar";
+  }
+}
+
+const Kernels &initKernels() {
+  const Kernels *table = selected.load(std::memory_order_acquire);
+  if (!table) {
+    // Racing callers select the same table, so the last store is harmless.
+    table = &selectKernels();
+    selected.store(table, std::memory_order_release);
+  }
+  return *table;
+}
+
+const Kernels &kernels() {
+  const Kernels *table = selected.load(std::memory_order_acquire);
+  return table ? *table : initKernels();
+}
+
+const Kernels *kernelsFor(SimdLevel level) {
+  return cpuSupports(level) ? compiledKernels(level) : nullptr;
+}
+
+} // namespace dsp
+} // namespace ms
@@ -0,0 +1,457 @@
+#include "KernelTables.hpp"
+
+// Compiled with AVX2 and FMA enabled. Only intrinsics and plain loops belong
+// here: an inline library function instantiated in this file could be
+// picked by the linker for the whole program and fault on older CPUs.
+#if defined(__AVX2__)
+#define MS_KERNELS_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace ms {
+namespace dsp {
+
+#if defined(MS_KERNELS_AVX2)
+
+namespace {
+
+void fillLinear(float *out, int numFrames, float start, float step) {
+  const __m256 vstart = _mm256_set1_ps(start);
+  const __m256 vstep = _mm256_set1_ps(step);
+  const __m256 eight = _mm256_set1_ps(8.0f);
+  __m256 index = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+  int i = 0;
+  for (; i + 8 <= numFrames; i += 8) {
+    _mm256_storeu_ps(out + i, _mm256_fmadd_ps(vstep, index, vstart));
+    index = _mm256_add_ps(index, eight);
+  }
+  for (; i < numFrames; ++i) {
+    out[i] = start + step * static_cast<float>(i);
+  }
+}
+
+void fillGeometric(float *out, int numFrames, float offset, float scale,
+                   float ratio) {
+  const float r2 = ratio * ratio;
+  const float r4 = r2 * r2;
+  const __m256 voffset = _mm256_set1_ps(offset);
+  const __m256 r8 = _mm256_set1_ps(r4 * r4);
+  __m256 powers = _mm256_mul_ps(
+      _mm256_set1_ps(scale),
+      _mm256_setr_ps(1.0f, ratio, r2, r2 * ratio, r4, r4 * ratio, r4 * r2,
+                     r4 * r2 * ratio));
+  int i = 0;
+  for (; i + 8 <= numFrames; i += 8) {
+    _mm256_storeu_ps(out + i, _mm256_add_ps(voffset, powers));
+    powers = _mm256_mul_ps(powers, r8);
+  }
+  scale = _mm256_cvtss_f32(powers);
+  for (; i < numFrames; ++i) {
+    out[i] = offset + scale;
+    scale *= ratio;
+  }
+}
+
+void scale(float *out, const float *in, int numFrames, float gain) {
+  const __m256 vgain = _mm256_set1_ps(gain);
+  int i = 0;
+  for (; i + 8 <= numFrames; i += 8) {
+    _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_loadu_ps(in + i), vgain));
+  }
+  for (; i < numFrames; ++i) {
+    out[i] = in[i] * gain;
+  }
+}
+
+void multiply(float *out, const float *in, const float *gains,
+              int numFrames) {
+  int i = 0;
+  for (; i + 8 <= numFrames; i += 8) {
+    _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_loadu_ps(in + i),
+                                            _mm256_loadu_ps(gains + i)));
+  }
+  for (; i < numFrames; ++i) {
+    out[i] = in[i] * gains[i];
+  }
+}
+
+void accumulate(float *out, const float *in, int numFrames, float gain) {
+  const __m256 vgain = _mm256_set1_ps(gain);
+  int i = 0;
+  for (; i + 8 <= numFrames; i += 8) {
+    _mm256_storeu_ps(out + i, _mm256_fmadd_ps(_mm256_loadu_ps(in + i), vgain,
+                                              _mm256_loadu_ps(out + i)));
+  }
+  for (; i < numFrames; ++i) {
+    out[i] += in[i] * gain;
+  }
+}
+
+void accumulateMultiply(float *out, const float *in, const float *gains,
+                        int numFrames) {
+  int i = 0;
+  for (; i + 8 <= numFrames; i += 8) {
+    _mm256_storeu_ps(out + i, _mm256_fmadd_ps(_mm256_loadu_ps(in + i),
+                                              _mm256_loadu_ps(gains + i),
+                                              _mm256_loadu_ps(out + i)));
+  }
+  for (; i < numFrames; ++i) {
+    out[i] += in[i] * gains[i];
+  }
+}
+
+/** Fractional part, x - floor(x). */
+__m256 fraction(__m256 x) {
+  return _mm256_sub_ps(x, _mm256_floor_ps(x));
+}
+
+/** sin(2 pi p) for p in [0, 1]; see the scalar variant. */
+__m256 sineOfPhase(__m256 phase) {
+  const __m256 signMask = _mm256_set1_ps(-0.0f);
+  const __m256 half = _mm256_set1_ps(0.5f);
+  const __m256 x = _mm256_sub_ps(phase, half);
+  const __m256 sign = _mm256_and_ps(x, signMask);
+  const __m256 magnitude = _mm256_andnot_ps(signMask, x);
+  const __m256 folded =
+      _mm256_min_ps(magnitude, _mm256_sub_ps(half, magnitude));
+  const __m256 y = _mm256_or_ps(folded, sign);
+  const __m256 y2 = _mm256_mul_ps(y, y);
+  __m256 poly = _mm256_set1_ps(kSineC11);
+  poly = _mm256_fmadd_ps(poly, y2, _mm256_set1_ps(kSineC9));
+  poly = _mm256_fmadd_ps(poly, y2, _mm256_set1_ps(kSineC7));
+  poly = _mm256_fmadd_ps(poly, y2, _mm256_set1_ps(kSineC5));
+  poly = _mm256_fmadd_ps(poly, y2, _mm256_set1_ps(kSineC3));
+  poly = _mm256_fmadd_ps(poly, y2, _mm256_set1_ps(kSineC1));
+  return _mm256_xor_ps(_mm256_mul_ps(poly, y), signMask);
+}
+
+/** PolyBLEP residual; the two regions are disjoint since dt < 0.5. */
+__m256 polyBlep(__m256 t, __m256 dt) {
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 low = _mm256_cmp_ps(t, dt, _CMP_LT_OQ);
+  const __m256 high = _mm256_cmp_ps(t, _mm256_sub_ps(one, dt), _CMP_GT_OQ);
+  const __m256 a = _mm256_sub_ps(_mm256_div_ps(t, dt), one);
+  const __m256 b =
+      _mm256_add_ps(_mm256_div_ps(_mm256_sub_ps(t, one), dt), one);
+  const __m256 lowValue =
+      _mm256_sub_ps(_mm256_setzero_ps(), _mm256_mul_ps(a, a));
+  return _mm256_blendv_ps(
+      _mm256_and_ps(high, _mm256_mul_ps(b, b)), lowValue, low);
+}
+
+__m256 shape(__m256 phase, __m256 dt, Waveform waveform) {
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 half = _mm256_set1_ps(0.5f);
+  switch (waveform) {
+  case Waveform::Saw: {
+    const __m256 naive = _mm256_sub_ps(_mm256_add_ps(phase, phase), one);
+    return _mm256_sub_ps(naive, polyBlep(phase, dt));
+  }
+  case Waveform::Square: {
+    const __m256 firstHalf = _mm256_cmp_ps(phase, half, _CMP_LT_OQ);
+    const __m256 shifted = _mm256_add_ps(phase, half);
+    const __m256 wrapped = _mm256_sub_ps(
+        shifted,
+        _mm256_and_ps(_mm256_cmp_ps(shifted, one, _CMP_GE_OQ), one));
+    const __m256 naive =
+        _mm256_blendv_ps(_mm256_set1_ps(-1.0f), one, firstHalf);
+    return _mm256_sub_ps(_mm256_add_ps(naive, polyBlep(phase, dt)),
+                         polyBlep(wrapped, dt));
+  }
+  default:
+    return sineOfPhase(phase);
+  }
+}
+
+void sine(float *out, const float *turns, int numFrames) {
+  int i = 0;
+  for (; i + 8 <= numFrames; i += 8) {
+    _mm256_storeu_ps(out + i,
+                     sineOfPhase(fraction(_mm256_loadu_ps(turns + i))));
+  }
+  if (i < numFrames) {
+    scalarKernels()->sine(out + i, turns + i, numFrames - i);
+  }
+}
+
+float oscillator(float *out, int numFrames, float phase, float increment,
+                 Waveform waveform) {
+  const __m256 dt = _mm256_set1_ps(increment);
+  const __m256 lanes =
+      _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+  for (int start = 0; start < numFrames; start += kPhaseChunk) {
+    const int length =
+        numFrames - start < kPhaseChunk ? numFrames - start : kPhaseChunk;
+    const __m256 base = _mm256_set1_ps(phase);
+    for (int i = 0; i < length; i += 8) {
+      const __m256 index =
+          _mm256_add_ps(lanes, _mm256_set1_ps(static_cast<float>(i)));
+      const __m256 value = shape(
+          fraction(_mm256_fmadd_ps(dt, index, base)), dt, waveform);
+      if (i + 8 <= length) {
+        _mm256_storeu_ps(out + start + i, value);
+      } else {
+        float rest[8];
+        _mm256_storeu_ps(rest, value);
+        for (int j = 0; j < length - i; ++j) {
+          out[start + i + j] = rest[j];
+        }
+      }
+    }
+    phase = advancePhase(phase, increment, length);
+  }
+  return phase;
+}
+
+float oscillatorModulated(float *out, const float *increments, int numFrames,
+                          float phase, Waveform waveform) {
+  // The phase recursion is inherently serial and cheap; shaping is not.
+  for (int i = 0; i < numFrames; ++i) {
+    out[i] = phase;
+    phase += increments[i];
+    if (phase >= 1.0f) {
+      phase -= 1.0f;
+    }
+  }
+  int i = 0;
+  for (; i + 8 <= numFrames; i += 8) {
+    _mm256_storeu_ps(out + i, shape(_mm256_loadu_ps(out + i),
+                                    _mm256_loadu_ps(increments + i),
+                                    waveform));
+  }
+  for (; i < numFrames; ++i) {
+    const __m256 value = shape(_mm256_set1_ps(out[i]),
+                               _mm256_set1_ps(increments[i]), waveform);
+    out[i] = _mm256_cvtss_f32(value);
+  }
+  return phase;
+}
+
+void biquad(float *out, const float *in, int numFrames,
+            const BiquadCoefficients &coefficients, BiquadState &state) {
+  constexpr int kLanes = 8;
+  if (numFrames < kLanes) {
+    scalarKernels()->biquad(out, in, numFrames, coefficients, state);
+    return;
+  }
+  float matrix[(4 + kLanes) * kLanes];
+  biquadResponseColumns(coefficients, kLanes, matrix);
+  __m256 columns[4 + kLanes];
+  for (int j = 0; j < 4 + kLanes; ++j) {
+    columns[j] = _mm256_loadu_ps(matrix + j * kLanes);
+  }
+
+  float x1 = state.x1;
+  float x2 = state.x2;
+  float y1 = state.y1;
+  float y2 = state.y2;
+  int i = 0;
+  for (; i + kLanes <= numFrames; i += kLanes) {
+    // The input terms do not depend on the previous block, so only the
+    // state terms sit on the critical path.
+    const float *x = in + i;
+    __m256 inputs = _mm256_mul_ps(columns[4], _mm256_broadcast_ss(x));
+    __m256 inputs2 = _mm256_mul_ps(columns[5], _mm256_broadcast_ss(x + 1));
+    inputs = _mm256_fmadd_ps(columns[6], _mm256_broadcast_ss(x + 2), inputs);
+    inputs2 =
+        _mm256_fmadd_ps(columns[7], _mm256_broadcast_ss(x + 3), inputs2);
+    inputs = _mm256_fmadd_ps(columns[8], _mm256_broadcast_ss(x + 4), inputs);
+    inputs2 =
+        _mm256_fmadd_ps(columns[9], _mm256_broadcast_ss(x + 5), inputs2);
+    inputs = _mm256_fmadd_ps(columns[10], _mm256_broadcast_ss(x + 6), inputs);
+    inputs2 =
+        _mm256_fmadd_ps(columns[11], _mm256_broadcast_ss(x + 7), inputs2);
+    __m256 history = _mm256_mul_ps(columns[0], _mm256_set1_ps(x1));
+    __m256 history2 = _mm256_mul_ps(columns[1], _mm256_set1_ps(x2));
+    history = _mm256_fmadd_ps(columns[2], _mm256_set1_ps(y1), history);
+    history2 = _mm256_fmadd_ps(columns[3], _mm256_set1_ps(y2), history2);
+    // Read the inputs the next block needs before out, which may alias in,
+    // is written.
+    x2 = x[kLanes - 2];
+    x1 = x[kLanes - 1];
+    _mm256_storeu_ps(out + i,
+                     _mm256_add_ps(_mm256_add_ps(inputs, inputs2),
+                                   _mm256_add_ps(history, history2)));
+    y2 = out[i + kLanes - 2];
+    y1 = out[i + kLanes - 1];
+  }
+  state.x1 = x1;
+  state.x2 = x2;
+  state.y1 = y1;
+  state.y2 = y2;
+  if (i < numFrames) {
+    scalarKernels()->biquad(out + i, in + i, numFrames - i, coefficients,
+                            state);
+  }
+}
+
+void interleave(float *out, const float *const *in, int numChannels,
+                int numFrames) {
+  if (numChannels != 2) {
+    scalarKernels()->interleave(out, in, numChannels, numFrames);
+    return;
+  }
+  const float *left = in[0];
+  const float *right = in[1];
+  int i = 0;
+  for (; i + 8 <= numFrames; i += 8) {
+    const __m256 l = _mm256_loadu_ps(left + i);
+    const __m256 r = _mm256_loadu_ps(right + i);
+    // unpack works within 128-bit halves: lo = l0 r0 l1 r1 | l4 r4 l5 r5.
+    const __m256 lo = _mm256_unpacklo_ps(l, r);
+    const __m256 hi = _mm256_unpackhi_ps(l, r);
+    _mm256_storeu_ps(out + 2 * i, _mm256_permute2f128_ps(lo, hi, 0x20));
+    _mm256_storeu_ps(out + 2 * i + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+  }
+  for (; i < numFrames; ++i) {
+    out[2 * i] = left[i];
+    out[2 * i + 1] = right[i];
+  }
+}
+
+void deinterleave(float *const *out, const float *in, int numChannels,
+                  int numFrames) {
+  if (numChannels != 2) {
+    scalarKernels()->deinterleave(out, in, numChannels, numFrames);
+    return;
+  }
+  float *left = out[0];
+  float *right = out[1];
+  int i = 0;
+  for (; i + 8 <= numFrames; i += 8) {
+    const __m256 a = _mm256_loadu_ps(in + 2 * i);
+    const __m256 b = _mm256_loadu_ps(in + 2 * i + 8);
+    // Regroup the halves so each holds frames 0-1 and 4-5, or 2-3 and 6-7,
+    // then pick the even and odd lanes.
+    const __m256 frames0 = _mm256_permute2f128_ps(a, b, 0x20);
+    const __m256 frames1 = _mm256_permute2f128_ps(a, b, 0x31);
+    _mm256_storeu_ps(left + i, _mm256_shuffle_ps(frames0, frames1,
+                                                 _MM_SHUFFLE(2, 0, 2, 0)));
+    _mm256_storeu_ps(right + i, _mm256_shuffle_ps(frames0, frames1,
+                                                  _MM_SHUFFLE(3, 1, 3, 1)));
+  }
+  for (; i < numFrames; ++i) {
+    left[i] = in[2 * i];
+    right[i] = in[2 * i + 1];
+  }
+}
+
+void voices(float *left, float *right, int numFrames, const VoiceBank &bank,
+            const int *groups, int numGroups) {
+  static_assert(kVoiceLanes == 8, "one AVX register per voice group");
+  if (numGroups == 0) {
+    return;
+  }
+  float *mixLeft = bank.mixLeft;
+  float *mixRight = bank.mixRight;
+  const __m256 zero = _mm256_setzero_ps();
+  for (int i = 0; i < numFrames * kVoiceLanes; i += 8) {
+    _mm256_storeu_ps(mixLeft + i, zero);
+    _mm256_storeu_ps(mixRight + i, zero);
+  }
+
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 sustain = _mm256_set1_ps(bank.sustain);
+  const __m256 decayRate = _mm256_set1_ps(bank.decayRate);
+  for (int g = 0; g < numGroups; ++g) {
+    const int v = groups[g] * kVoiceLanes;
+    __m256 phase = _mm256_loadu_ps(bank.phase + v);
+    const __m256 increment = _mm256_loadu_ps(bank.increment + v);
+    const __m256 b0 = _mm256_loadu_ps(bank.b0 + v);
+    const __m256 b1 = _mm256_loadu_ps(bank.b1 + v);
+    const __m256 b2 = _mm256_loadu_ps(bank.b2 + v);
+    const __m256 a1 = _mm256_loadu_ps(bank.a1 + v);
+    const __m256 a2 = _mm256_loadu_ps(bank.a2 + v);
+    __m256 x1 = _mm256_loadu_ps(bank.x1 + v);
+    __m256 x2 = _mm256_loadu_ps(bank.x2 + v);
+    __m256 y1 = _mm256_loadu_ps(bank.y1 + v);
+    __m256 y2 = _mm256_loadu_ps(bank.y2 + v);
+    __m256 level = _mm256_loadu_ps(bank.level + v);
+    __m256 target = _mm256_loadu_ps(bank.target + v);
+    __m256 rate = _mm256_loadu_ps(bank.rate + v);
+    const __m256 gainLeft = _mm256_loadu_ps(bank.gainLeft + v);
+    const __m256 gainRight = _mm256_loadu_ps(bank.gainRight + v);
+
+    for (int i = 0; i < numFrames; ++i) {
+      const __m256 x0 = shape(phase, increment, bank.waveform);
+      phase = _mm256_add_ps(phase, increment);
+      phase = _mm256_sub_ps(
+          phase, _mm256_and_ps(_mm256_cmp_ps(phase, one, _CMP_GE_OQ), one));
+      __m256 y0 = _mm256_mul_ps(b0, x0);
+      y0 = _mm256_fmadd_ps(b1, x1, y0);
+      y0 = _mm256_fmadd_ps(b2, x2, y0);
+      y0 = _mm256_fnmadd_ps(a1, y1, y0);
+      y0 = _mm256_fnmadd_ps(a2, y2, y0);
+      x2 = x1;
+      x1 = x0;
+      y2 = y1;
+      y1 = y0;
+      level = _mm256_fmadd_ps(_mm256_sub_ps(target, level), rate, level);
+      const __m256 attackDone =
+          _mm256_and_ps(_mm256_cmp_ps(target, one, _CMP_GT_OQ),
+                        _mm256_cmp_ps(level, one, _CMP_GE_OQ));
+      level = _mm256_blendv_ps(level, one, attackDone);
+      target = _mm256_blendv_ps(target, sustain, attackDone);
+      rate = _mm256_blendv_ps(rate, decayRate, attackDone);
+      const __m256 out = _mm256_mul_ps(y0, level);
+      float *l = mixLeft + i * kVoiceLanes;
+      float *r = mixRight + i * kVoiceLanes;
+      _mm256_storeu_ps(l, _mm256_fmadd_ps(out, gainLeft, _mm256_loadu_ps(l)));
+      _mm256_storeu_ps(r,
+                       _mm256_fmadd_ps(out, gainRight, _mm256_loadu_ps(r)));
+    }
+
+    _mm256_storeu_ps(bank.phase + v, phase);
+    _mm256_storeu_ps(bank.x1 + v, x1);
+    _mm256_storeu_ps(bank.x2 + v, x2);
+    _mm256_storeu_ps(bank.y1 + v, y1);
+    _mm256_storeu_ps(bank.y2 + v, y2);
+    _mm256_storeu_ps(bank.level + v, level);
+    _mm256_storeu_ps(bank.target + v, target);
+    _mm256_storeu_ps(bank.rate + v, rate);
+  }
+
+  // Sum the lanes of each frame: both channels share the horizontal adds.
+  for (int i = 0; i < numFrames; ++i) {
+    const __m256 l = _mm256_loadu_ps(mixLeft + i * kVoiceLanes);
+    const __m256 r = _mm256_loadu_ps(mixRight + i * kVoiceLanes);
+    const __m128 l4 = _mm_add_ps(_mm256_castps256_ps128(l),
+                                 _mm256_extractf128_ps(l, 1));
+    const __m128 r4 = _mm_add_ps(_mm256_castps256_ps128(r),
+                                 _mm256_extractf128_ps(r, 1));
+    const __m128 pairs = _mm_hadd_ps(l4, r4);
+    const __m128 sums = _mm_hadd_ps(pairs, pairs);
+    left[i] += _mm_cvtss_f32(sums);
+    right[i] += _mm_cvtss_f32(_mm_shuffle_ps(sums, sums, 1));
+  }
+}
+
+const Kernels table = {
+    SimdLevel::AVX2,
+    fillLinear,
+    fillGeometric,
+    scale,
+    multiply,
+    accumulate,
+    accumulateMultiply,
+    sine,
+    oscillator,
+    oscillatorModulated,
+    biquad,
+    interleave,
+    deinterleave,
+    voices,
+};
+
+} // namespace
+
+const Kernels *avx2Kernels() { return &table; }
+
+#else
+
+const Kernels *avx2Kernels() { return nullptr; }
+
+#endif
+
+} // namespace dsp
+} // namespace ms
@@ -0,0 +1,301 @@
+#include "KernelTables.hpp"
+
+namespace ms {
+namespace dsp {
+
+namespace {
+
+void fillLinear(float *out, int numFrames, float start, float step) {
+  for (int i = 0; i < numFrames; ++i) {
+    out[i] = start + step * static_cast<float>(i);
+  }
+}
+
+void fillGeometric(float *out, int numFrames, float offset, float scale,
+                   float ratio) {
+  for (int i = 0; i < numFrames; ++i) {
+    out[i] = offset + scale;
+    scale *= ratio;
+  }
+}
+
+void scale(float *out, const float *in, int numFrames, float gain) {
+  for (int i = 0; i < numFrames; ++i) {
+    out[i] = in[i] * gain;
+  }
+}
+
+void multiply(float *out, const float *in, const float *gains,
+              int numFrames) {
+  for (int i = 0; i < numFrames; ++i) {
+    out[i] = in[i] * gains[i];
+  }
+}
+
+void accumulate(float *out, const float *in, int numFrames, float gain) {
+  for (int i = 0; i < numFrames; ++i) {
+    out[i] += in[i] * gain;
+  }
+}
+
+void accumulateMultiply(float *out, const float *in, const float *gains,
+                        int numFrames) {
+  for (int i = 0; i < numFrames; ++i) {
+    out[i] += in[i] * gains[i];
+  }
+}
+
+float wrap(float phase) {
+  const float floor = static_cast<float>(static_cast<int>(phase));
+  const float fraction = phase - floor;
+  return fraction < 0.0f ? fraction + 1.0f : fraction;
+}
+
+float sineOfPhase(float phase) {
+  // sin(2 pi p) = -sin(2 pi x) with x = p - 0.5; x is folded into
+  // [-0.25, 0.25] where a degree 11 polynomial is accurate to ~1e-7.
+  const float x = phase - 0.5f;
+  const float magnitude = x < 0.0f ? -x : x;
+  const float folded = magnitude < 0.5f - magnitude ? magnitude
+                                                     : 0.5f - magnitude;
+  const float y = x < 0.0f ? -folded : folded;
+  const float y2 = y * y;
+  float poly = kSineC11;
+  poly = poly * y2 + kSineC9;
+  poly = poly * y2 + kSineC7;
+  poly = poly * y2 + kSineC5;
+  poly = poly * y2 + kSineC3;
+  poly = poly * y2 + kSineC1;
+  return -(poly * y);
+}
+
+float polyBlep(float t, float dt) {
+  if (t < dt) {
+    const float a = t / dt - 1.0f;
+    return -(a * a);
+  }
+  if (t > 1.0f - dt) {
+    const float b = (t - 1.0f) / dt + 1.0f;
+    return b * b;
+  }
+  return 0.0f;
+}
+
+float shape(float phase, float dt, Waveform waveform) {
+  switch (waveform) {
+  case Waveform::Saw:
+    return 2.0f * phase - 1.0f - polyBlep(phase, dt);
+  case Waveform::Square: {
+    const float half = phase < 0.5f ? phase + 0.5f : phase - 0.5f;
+    return (phase < 0.5f ? 1.0f : -1.0f) + polyBlep(phase, dt) -
+           polyBlep(half, dt);
+  }
+  default:
+    return sineOfPhase(phase);
+  }
+}
+
+void sine(float *out, const float *turns, int numFrames) {
+  for (int i = 0; i < numFrames; ++i) {
+    out[i] = sineOfPhase(wrap(turns[i]));
+  }
+}
+
+float oscillator(float *out, int numFrames, float phase, float increment,
+                 Waveform waveform) {
+  for (int start = 0; start < numFrames; start += kPhaseChunk) {
+    const int length =
+        numFrames - start < kPhaseChunk ? numFrames - start : kPhaseChunk;
+    for (int i = 0; i < length; ++i) {
+      const float t = phase + increment * static_cast<float>(i);
+      out[start + i] = shape(wrap(t), increment, waveform);
+    }
+    phase = advancePhase(phase, increment, length);
+  }
+  return phase;
+}
+
+float oscillatorModulated(float *out, const float *increments, int numFrames,
+                          float phase, Waveform waveform) {
+  for (int i = 0; i < numFrames; ++i) {
+    out[i] = shape(phase, increments[i], waveform);
+    phase += increments[i];
+    if (phase >= 1.0f) {
+      phase -= 1.0f;
+    }
+  }
+  return phase;
+}
+
+void biquad(float *out, const float *in, int numFrames,
+            const BiquadCoefficients &c, BiquadState &state) {
+  float x1 = state.x1;
+  float x2 = state.x2;
+  float y1 = state.y1;
+  float y2 = state.y2;
+  for (int i = 0; i < numFrames; ++i) {
+    const float x0 = in[i];
+    const float y0 = c.b0 * x0 + c.b1 * x1 + c.b2 * x2 - c.a1 * y1 - c.a2 * y2;
+    x2 = x1;
+    x1 = x0;
+    y2 = y1;
+    y1 = y0;
+    out[i] = y0;
+  }
+  state.x1 = x1;
+  state.x2 = x2;
+  state.y1 = y1;
+  state.y2 = y2;
+}
+
+void interleave(float *out, const float *const *in, int numChannels,
+                int numFrames) {
+  for (int c = 0; c < numChannels; ++c) {
+    const float *channel = in[c];
+    for (int i = 0; i < numFrames; ++i) {
+      out[i * numChannels + c] = channel[i];
+    }
+  }
+}
+
+void deinterleave(float *const *out, const float *in, int numChannels,
+                  int numFrames) {
+  for (int c = 0; c < numChannels; ++c) {
+    float *channel = out[c];
+    for (int i = 0; i < numFrames; ++i) {
+      channel[i] = in[i * numChannels + c];
+    }
+  }
+}
+
+void voices(float *left, float *right, int numFrames, const VoiceBank &bank,
+            const int *groups, int numGroups) {
+  if (numGroups == 0) {
+    return;
+  }
+  float *mixLeft = bank.mixLeft;
+  float *mixRight = bank.mixRight;
+  for (int i = 0; i < numFrames * kVoiceLanes; ++i) {
+    mixLeft[i] = 0.0f;
+    mixRight[i] = 0.0f;
+  }
+
+  for (int g = 0; g < numGroups; ++g) {
+    for (int lane = 0; lane < kVoiceLanes; ++lane) {
+      const int v = groups[g] * kVoiceLanes + lane;
+      float phase = bank.phase[v];
+      const float increment = bank.increment[v];
+      const float b0 = bank.b0[v];
+      const float b1 = bank.b1[v];
+      const float b2 = bank.b2[v];
+      const float a1 = bank.a1[v];
+      const float a2 = bank.a2[v];
+      float x1 = bank.x1[v];
+      float x2 = bank.x2[v];
+      float y1 = bank.y1[v];
+      float y2 = bank.y2[v];
+      float level = bank.level[v];
+      float target = bank.target[v];
+      float rate = bank.rate[v];
+      const float gainLeft = bank.gainLeft[v];
+      const float gainRight = bank.gainRight[v];
+
+      for (int i = 0; i < numFrames; ++i) {
+        const float x0 = shape(phase, increment, bank.waveform);
+        phase += increment;
+        if (phase >= 1.0f) {
+          phase -= 1.0f;
+        }
+        const float y0 = b0 * x0 + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+        x2 = x1;
+        x1 = x0;
+        y2 = y1;
+        y1 = y0;
+        level += (target - level) * rate;
+        if (target > 1.0f && level >= 1.0f) {
+          level = 1.0f;
+          target = bank.sustain;
+          rate = bank.decayRate;
+        }
+        const float out = y0 * level;
+        mixLeft[i * kVoiceLanes + lane] += out * gainLeft;
+        mixRight[i * kVoiceLanes + lane] += out * gainRight;
+      }
+
+      bank.phase[v] = phase;
+      bank.x1[v] = x1;
+      bank.x2[v] = x2;
+      bank.y1[v] = y1;
+      bank.y2[v] = y2;
+      bank.level[v] = level;
+      bank.target[v] = target;
+      bank.rate[v] = rate;
+    }
+  }
+
+  for (int i = 0; i < numFrames; ++i) {
+    float sumLeft = 0.0f;
+    float sumRight = 0.0f;
+    for (int lane = 0; lane < kVoiceLanes; ++lane) {
+      sumLeft += mixLeft[i * kVoiceLanes + lane];
+      sumRight += mixRight[i * kVoiceLanes + lane];
+    }
+    left[i] += sumLeft;
+    right[i] += sumRight;
+  }
+}
+
+const Kernels table = {
+    SimdLevel::Scalar,
+    fillLinear,
+    fillGeometric,
+    scale,
+    multiply,
+    accumulate,
+    accumulateMultiply,
+    sine,
+    oscillator,
+    oscillatorModulated,
+    biquad,
+    interleave,
+    deinterleave,
+    voices,
+};
+
+} // namespace
+
+const Kernels *scalarKernels() { return &table; }
+
+float advancePhase(float phase, float increment, int numFrames) {
+  return wrap(phase + increment * static_cast<float>(numFrames));
+}
+
+void biquadResponseColumns(const BiquadCoefficients &c, int lanes,
+                           float *columns) {
+  // Column j holds the first `lanes` outputs for the j-th unit initial
+  // condition: x1, x2, y1, y2, then an impulse at each input position.
+  // Evaluated in double: rounding errors in these powers of the state
+  // matrix would move the poles of resonant filters audibly.
+  for (int j = 0; j < 4 + lanes; ++j) {
+    double x1 = j == 0 ? 1.0 : 0.0;
+    double x2 = j == 1 ? 1.0 : 0.0;
+    double y1 = j == 2 ? 1.0 : 0.0;
+    double y2 = j == 3 ? 1.0 : 0.0;
+    for (int k = 0; k < lanes; ++k) {
+      const double x0 = k == j - 4 ? 1.0 : 0.0;
+      const double y0 = static_cast<double>(c.b0) * x0 +
+                        static_cast<double>(c.b1) * x1 +
+                        static_cast<double>(c.b2) * x2 -
+                        static_cast<double>(c.a1) * y1 -
+                        static_cast<double>(c.a2) * y2;
+      x2 = x1;
+      x1 = x0;
+      y2 = y1;
+      y1 = y0;
+      columns[j * lanes + k] = static_cast<float>(y0);
+    }
+  }
+}
+
+} // namespace dsp
+} // namespace ms
@@ -0,0 +1,442 @@
+#include "KernelTables.hpp"
+
+// Compiled with SSE2 enabled. Only intrinsics and plain loops belong here:
+// an inline library function instantiated in this file could be picked by
+// the linker for the whole program.
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MS_KERNELS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace ms {
+namespace dsp {
+
+#if defined(MS_KERNELS_SSE2)
+
+namespace {
+
+void fillLinear(float *out, int numFrames, float start, float step) {
+  const __m128 vstart = _mm_set1_ps(start);
+  const __m128 vstep = _mm_set1_ps(step);
+  const __m128 four = _mm_set1_ps(4.0f);
+  __m128 index = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+  int i = 0;
+  for (; i + 4 <= numFrames; i += 4) {
+    _mm_storeu_ps(out + i, _mm_add_ps(vstart, _mm_mul_ps(vstep, index)));
+    index = _mm_add_ps(index, four);
+  }
+  for (; i < numFrames; ++i) {
+    out[i] = start + step * static_cast<float>(i);
+  }
+}
+
+void fillGeometric(float *out, int numFrames, float offset, float scale,
+                   float ratio) {
+  const float r2 = ratio * ratio;
+  const __m128 voffset = _mm_set1_ps(offset);
+  const __m128 r4 = _mm_set1_ps(r2 * r2);
+  __m128 powers = _mm_mul_ps(_mm_set1_ps(scale),
+                             _mm_setr_ps(1.0f, ratio, r2, r2 * ratio));
+  int i = 0;
+  for (; i + 4 <= numFrames; i += 4) {
+    _mm_storeu_ps(out + i, _mm_add_ps(voffset, powers));
+    powers = _mm_mul_ps(powers, r4);
+  }
+  scale = _mm_cvtss_f32(powers);
+  for (; i < numFrames; ++i) {
+    out[i] = offset + scale;
+    scale *= ratio;
+  }
+}
+
+void scale(float *out, const float *in, int numFrames, float gain) {
+  const __m128 vgain = _mm_set1_ps(gain);
+  int i = 0;
+  for (; i + 4 <= numFrames; i += 4) {
+    _mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(in + i), vgain));
+  }
+  for (; i < numFrames; ++i) {
+    out[i] = in[i] * gain;
+  }
+}
+
+void multiply(float *out, const float *in, const float *gains,
+              int numFrames) {
+  int i = 0;
+  for (; i + 4 <= numFrames; i += 4) {
+    _mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(in + i),
+                                      _mm_loadu_ps(gains + i)));
+  }
+  for (; i < numFrames; ++i) {
+    out[i] = in[i] * gains[i];
+  }
+}
+
+void accumulate(float *out, const float *in, int numFrames, float gain) {
+  const __m128 vgain = _mm_set1_ps(gain);
+  int i = 0;
+  for (; i + 4 <= numFrames; i += 4) {
+    const __m128 product = _mm_mul_ps(_mm_loadu_ps(in + i), vgain);
+    _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), product));
+  }
+  for (; i < numFrames; ++i) {
+    out[i] += in[i] * gain;
+  }
+}
+
+void accumulateMultiply(float *out, const float *in, const float *gains,
+                        int numFrames) {
+  int i = 0;
+  for (; i + 4 <= numFrames; i += 4) {
+    const __m128 product =
+        _mm_mul_ps(_mm_loadu_ps(in + i), _mm_loadu_ps(gains + i));
+    _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), product));
+  }
+  for (; i < numFrames; ++i) {
+    out[i] += in[i] * gains[i];
+  }
+}
+
+/** Fractional part, x - floor(x), for |x| < 2^31. */
+__m128 fraction(__m128 x) {
+  const __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+  const __m128 floor = _mm_sub_ps(
+      truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, x), _mm_set1_ps(1.0f)));
+  return _mm_sub_ps(x, floor);
+}
+
+/** sin(2 pi p) for p in [0, 1]; see the scalar variant. */
+__m128 sineOfPhase(__m128 phase) {
+  const __m128 signMask = _mm_set1_ps(-0.0f);
+  const __m128 x = _mm_sub_ps(phase, _mm_set1_ps(0.5f));
+  const __m128 sign = _mm_and_ps(x, signMask);
+  const __m128 magnitude = _mm_andnot_ps(signMask, x);
+  const __m128 folded =
+      _mm_min_ps(magnitude, _mm_sub_ps(_mm_set1_ps(0.5f), magnitude));
+  const __m128 y = _mm_or_ps(folded, sign);
+  const __m128 y2 = _mm_mul_ps(y, y);
+  __m128 poly = _mm_set1_ps(kSineC11);
+  poly = _mm_add_ps(_mm_mul_ps(poly, y2), _mm_set1_ps(kSineC9));
+  poly = _mm_add_ps(_mm_mul_ps(poly, y2), _mm_set1_ps(kSineC7));
+  poly = _mm_add_ps(_mm_mul_ps(poly, y2), _mm_set1_ps(kSineC5));
+  poly = _mm_add_ps(_mm_mul_ps(poly, y2), _mm_set1_ps(kSineC3));
+  poly = _mm_add_ps(_mm_mul_ps(poly, y2), _mm_set1_ps(kSineC1));
+  return _mm_xor_ps(_mm_mul_ps(poly, y), signMask);
+}
+
+/** PolyBLEP residual; the two regions are disjoint since dt < 0.5. */
+__m128 polyBlep(__m128 t, __m128 dt) {
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 low = _mm_cmplt_ps(t, dt);
+  const __m128 high = _mm_cmpgt_ps(t, _mm_sub_ps(one, dt));
+  const __m128 a = _mm_sub_ps(_mm_div_ps(t, dt), one);
+  const __m128 b = _mm_add_ps(_mm_div_ps(_mm_sub_ps(t, one), dt), one);
+  const __m128 lowValue = _mm_sub_ps(_mm_setzero_ps(), _mm_mul_ps(a, a));
+  return _mm_or_ps(_mm_and_ps(low, lowValue),
+                   _mm_and_ps(high, _mm_mul_ps(b, b)));
+}
+
+__m128 shape(__m128 phase, __m128 dt, Waveform waveform) {
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 half = _mm_set1_ps(0.5f);
+  switch (waveform) {
+  case Waveform::Saw: {
+    const __m128 naive = _mm_sub_ps(_mm_add_ps(phase, phase), one);
+    return _mm_sub_ps(naive, polyBlep(phase, dt));
+  }
+  case Waveform::Square: {
+    const __m128 firstHalf = _mm_cmplt_ps(phase, half);
+    const __m128 shifted = _mm_add_ps(phase, half);
+    const __m128 wrapped = _mm_sub_ps(
+        shifted, _mm_and_ps(_mm_cmpge_ps(shifted, one), one));
+    const __m128 naive =
+        _mm_or_ps(_mm_and_ps(firstHalf, one),
+                  _mm_andnot_ps(firstHalf, _mm_set1_ps(-1.0f)));
+    return _mm_sub_ps(_mm_add_ps(naive, polyBlep(phase, dt)),
+                      polyBlep(wrapped, dt));
+  }
+  default:
+    return sineOfPhase(phase);
+  }
+}
+
+void sine(float *out, const float *turns, int numFrames) {
+  int i = 0;
+  for (; i + 4 <= numFrames; i += 4) {
+    _mm_storeu_ps(out + i, sineOfPhase(fraction(_mm_loadu_ps(turns + i))));
+  }
+  if (i < numFrames) {
+    scalarKernels()->sine(out + i, turns + i, numFrames - i);
+  }
+}
+
+float oscillator(float *out, int numFrames, float phase, float increment,
+                 Waveform waveform) {
+  const __m128 dt = _mm_set1_ps(increment);
+  const __m128 lanes = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+  for (int start = 0; start < numFrames; start += kPhaseChunk) {
+    const int length =
+        numFrames - start < kPhaseChunk ? numFrames - start : kPhaseChunk;
+    const __m128 base = _mm_set1_ps(phase);
+    for (int i = 0; i < length; i += 4) {
+      const __m128 index =
+          _mm_add_ps(lanes, _mm_set1_ps(static_cast<float>(i)));
+      const __m128 value = shape(
+          fraction(_mm_add_ps(base, _mm_mul_ps(dt, index))), dt, waveform);
+      if (i + 4 <= length) {
+        _mm_storeu_ps(out + start + i, value);
+      } else {
+        float rest[4];
+        _mm_storeu_ps(rest, value);
+        for (int j = 0; j < length - i; ++j) {
+          out[start + i + j] = rest[j];
+        }
+      }
+    }
+    phase = advancePhase(phase, increment, length);
+  }
+  return phase;
+}
+
+float oscillatorModulated(float *out, const float *increments, int numFrames,
+                          float phase, Waveform waveform) {
+  // The phase recursion is inherently serial and cheap; shaping is not.
+  for (int i = 0; i < numFrames; ++i) {
+    out[i] = phase;
+    phase += increments[i];
+    if (phase >= 1.0f) {
+      phase -= 1.0f;
+    }
+  }
+  int i = 0;
+  for (; i + 4 <= numFrames; i += 4) {
+    _mm_storeu_ps(out + i, shape(_mm_loadu_ps(out + i),
+                                 _mm_loadu_ps(increments + i), waveform));
+  }
+  for (; i < numFrames; ++i) {
+    const __m128 value = shape(_mm_set_ss(out[i]),
+                               _mm_set_ss(increments[i]), waveform);
+    out[i] = _mm_cvtss_f32(value);
+  }
+  return phase;
+}
+
+void biquad(float *out, const float *in, int numFrames,
+            const BiquadCoefficients &coefficients, BiquadState &state) {
+  constexpr int kLanes = 4;
+  if (numFrames < kLanes) {
+    scalarKernels()->biquad(out, in, numFrames, coefficients, state);
+    return;
+  }
+  float matrix[(4 + kLanes) * kLanes];
+  biquadResponseColumns(coefficients, kLanes, matrix);
+  __m128 columns[4 + kLanes];
+  for (int j = 0; j < 4 + kLanes; ++j) {
+    columns[j] = _mm_loadu_ps(matrix + j * kLanes);
+  }
+
+  float x1 = state.x1;
+  float x2 = state.x2;
+  float y1 = state.y1;
+  float y2 = state.y2;
+  int i = 0;
+  for (; i + kLanes <= numFrames; i += kLanes) {
+    // The input terms do not depend on the previous block, so only the
+    // state terms sit on the critical path.
+    __m128 inputs = _mm_mul_ps(columns[4], _mm_set1_ps(in[i]));
+    __m128 inputs2 = _mm_mul_ps(columns[5], _mm_set1_ps(in[i + 1]));
+    inputs = _mm_add_ps(inputs, _mm_mul_ps(columns[6], _mm_set1_ps(in[i + 2])));
+    inputs2 =
+        _mm_add_ps(inputs2, _mm_mul_ps(columns[7], _mm_set1_ps(in[i + 3])));
+    __m128 history = _mm_mul_ps(columns[0], _mm_set1_ps(x1));
+    __m128 history2 = _mm_mul_ps(columns[1], _mm_set1_ps(x2));
+    history = _mm_add_ps(history, _mm_mul_ps(columns[2], _mm_set1_ps(y1)));
+    history2 = _mm_add_ps(history2, _mm_mul_ps(columns[3], _mm_set1_ps(y2)));
+    // Read the inputs the next block needs before out, which may alias in,
+    // is written.
+    x2 = in[i + kLanes - 2];
+    x1 = in[i + kLanes - 1];
+    _mm_storeu_ps(out + i, _mm_add_ps(_mm_add_ps(inputs, inputs2),
+                                      _mm_add_ps(history, history2)));
+    y2 = out[i + kLanes - 2];
+    y1 = out[i + kLanes - 1];
+  }
+  state.x1 = x1;
+  state.x2 = x2;
+  state.y1 = y1;
+  state.y2 = y2;
+  if (i < numFrames) {
+    scalarKernels()->biquad(out + i, in + i, numFrames - i, coefficients,
+                            state);
+  }
+}
+
+void interleave(float *out, const float *const *in, int numChannels,
+                int numFrames) {
+  if (numChannels != 2) {
+    scalarKernels()->interleave(out, in, numChannels, numFrames);
+    return;
+  }
+  const float *left = in[0];
+  const float *right = in[1];
+  int i = 0;
+  for (; i + 4 <= numFrames; i += 4) {
+    const __m128 l = _mm_loadu_ps(left + i);
+    const __m128 r = _mm_loadu_ps(right + i);
+    _mm_storeu_ps(out + 2 * i, _mm_unpacklo_ps(l, r));
+    _mm_storeu_ps(out + 2 * i + 4, _mm_unpackhi_ps(l, r));
+  }
+  for (; i < numFrames; ++i) {
+    out[2 * i] = left[i];
+    out[2 * i + 1] = right[i];
+  }
+}
+
+void deinterleave(float *const *out, const float *in, int numChannels,
+                  int numFrames) {
+  if (numChannels != 2) {
+    scalarKernels()->deinterleave(out, in, numChannels, numFrames);
+    return;
+  }
+  float *left = out[0];
+  float *right = out[1];
+  int i = 0;
+  for (; i + 4 <= numFrames; i += 4) {
+    const __m128 a = _mm_loadu_ps(in + 2 * i);
+    const __m128 b = _mm_loadu_ps(in + 2 * i + 4);
+    _mm_storeu_ps(left + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+    _mm_storeu_ps(right + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+  }
+  for (; i < numFrames; ++i) {
+    left[i] = in[2 * i];
+    right[i] = in[2 * i + 1];
+  }
+}
+
+/** Lanes of mask set take a, the others b. */
+__m128 select(__m128 mask, __m128 a, __m128 b) {
+  return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+void voices(float *left, float *right, int numFrames, const VoiceBank &bank,
+            const int *groups, int numGroups) {
+  static_assert(kVoiceLanes == 8, "two SSE registers per voice group");
+  if (numGroups == 0) {
+    return;
+  }
+  float *mixLeft = bank.mixLeft;
+  float *mixRight = bank.mixRight;
+  const __m128 zero = _mm_setzero_ps();
+  for (int i = 0; i < numFrames * kVoiceLanes; i += 4) {
+    _mm_storeu_ps(mixLeft + i, zero);
+    _mm_storeu_ps(mixRight + i, zero);
+  }
+
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 sustain = _mm_set1_ps(bank.sustain);
+  const __m128 decayRate = _mm_set1_ps(bank.decayRate);
+  for (int g = 0; g < numGroups; ++g) {
+    // Each half of the group is rendered on its own.
+    for (int half = 0; half < kVoiceLanes; half += 4) {
+      const int v = groups[g] * kVoiceLanes + half;
+      __m128 phase = _mm_loadu_ps(bank.phase + v);
+      const __m128 increment = _mm_loadu_ps(bank.increment + v);
+      const __m128 b0 = _mm_loadu_ps(bank.b0 + v);
+      const __m128 b1 = _mm_loadu_ps(bank.b1 + v);
+      const __m128 b2 = _mm_loadu_ps(bank.b2 + v);
+      const __m128 a1 = _mm_loadu_ps(bank.a1 + v);
+      const __m128 a2 = _mm_loadu_ps(bank.a2 + v);
+      __m128 x1 = _mm_loadu_ps(bank.x1 + v);
+      __m128 x2 = _mm_loadu_ps(bank.x2 + v);
+      __m128 y1 = _mm_loadu_ps(bank.y1 + v);
+      __m128 y2 = _mm_loadu_ps(bank.y2 + v);
+      __m128 level = _mm_loadu_ps(bank.level + v);
+      __m128 target = _mm_loadu_ps(bank.target + v);
+      __m128 rate = _mm_loadu_ps(bank.rate + v);
+      const __m128 gainLeft = _mm_loadu_ps(bank.gainLeft + v);
+      const __m128 gainRight = _mm_loadu_ps(bank.gainRight + v);
+
+      for (int i = 0; i < numFrames; ++i) {
+        const __m128 x0 = shape(phase, increment, bank.waveform);
+        phase = _mm_add_ps(phase, increment);
+        phase = _mm_sub_ps(phase, _mm_and_ps(_mm_cmpge_ps(phase, one), one));
+        __m128 y0 = _mm_mul_ps(b0, x0);
+        y0 = _mm_add_ps(y0, _mm_mul_ps(b1, x1));
+        y0 = _mm_add_ps(y0, _mm_mul_ps(b2, x2));
+        y0 = _mm_sub_ps(y0, _mm_mul_ps(a1, y1));
+        y0 = _mm_sub_ps(y0, _mm_mul_ps(a2, y2));
+        x2 = x1;
+        x1 = x0;
+        y2 = y1;
+        y1 = y0;
+        level = _mm_add_ps(level,
+                           _mm_mul_ps(_mm_sub_ps(target, level), rate));
+        const __m128 attackDone =
+            _mm_and_ps(_mm_cmpgt_ps(target, one), _mm_cmpge_ps(level, one));
+        level = select(attackDone, one, level);
+        target = select(attackDone, sustain, target);
+        rate = select(attackDone, decayRate, rate);
+        const __m128 out = _mm_mul_ps(y0, level);
+        float *l = mixLeft + i * kVoiceLanes + half;
+        float *r = mixRight + i * kVoiceLanes + half;
+        _mm_storeu_ps(l, _mm_add_ps(_mm_loadu_ps(l), _mm_mul_ps(out, gainLeft)));
+        _mm_storeu_ps(r,
+                      _mm_add_ps(_mm_loadu_ps(r), _mm_mul_ps(out, gainRight)));
+      }
+
+      _mm_storeu_ps(bank.phase + v, phase);
+      _mm_storeu_ps(bank.x1 + v, x1);
+      _mm_storeu_ps(bank.x2 + v, x2);
+      _mm_storeu_ps(bank.y1 + v, y1);
+      _mm_storeu_ps(bank.y2 + v, y2);
+      _mm_storeu_ps(bank.level + v, level);
+      _mm_storeu_ps(bank.target + v, target);
+      _mm_storeu_ps(bank.rate + v, rate);
+    }
+  }
+
+  for (int i = 0; i < numFrames; ++i) {
+    const float *l = mixLeft + i * kVoiceLanes;
+    const float *r = mixRight + i * kVoiceLanes;
+    // Interleave the channels so that one add tree sums both.
+    const __m128 l4 = _mm_add_ps(_mm_loadu_ps(l), _mm_loadu_ps(l + 4));
+    const __m128 r4 = _mm_add_ps(_mm_loadu_ps(r), _mm_loadu_ps(r + 4));
+    const __m128 low = _mm_unpacklo_ps(l4, r4);
+    const __m128 high = _mm_unpackhi_ps(l4, r4);
+    const __m128 pairs = _mm_add_ps(low, high);
+    const __m128 sums = _mm_add_ps(pairs, _mm_movehl_ps(pairs, pairs));
+    left[i] += _mm_cvtss_f32(sums);
+    right[i] += _mm_cvtss_f32(_mm_shuffle_ps(sums, sums, 1));
+  }
+}
+
+const Kernels table = {
+    SimdLevel::SSE2,
+    fillLinear,
+    fillGeometric,
+    scale,
+    multiply,
+    accumulate,
+    accumulateMultiply,
+    sine,
+    oscillator,
+    oscillatorModulated,
+    biquad,
+    interleave,
+    deinterleave,
+    voices,
+};
+
+} // namespace
+
+const Kernels *sse2Kernels() { return &table; }
+
+#else
+
+const Kernels *sse2Kernels() { return nullptr; }
+
+#endif
+
+} // namespace dsp
+} // namespace ms
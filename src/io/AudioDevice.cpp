@@ -0,0 +1,157 @@
+#include "io/AudioDevice.hpp"
+#include "../core/Error.hpp"
+#include "miniaudio.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace ms {
+
+struct AudioDevice::Device {
+  ma_context context;
+  ma_device device;
+  bool hasContext = false;
+  bool hasDevice = false;
+
+  ~Device() {
+    if (hasDevice) {
+      ma_device_uninit(&device);
+    }
+    if (hasContext) {
+      ma_context_uninit(&context);
+    }
+  }
+};
+
+AudioDevice::AudioDevice() = default;
+
+AudioDevice::~AudioDevice() { close(); }
+
+bool AudioDevice::open(const Graph &graph, const AudioDeviceOptions &options,
+                       std::string *error) {
+  close();
+  if (options.blockSize <= 0 || options.sampleRate <= 0.0 ||
+      options.numInputs < 0 || options.numOutputs < 0 ||
+      options.numInputs + options.numOutputs == 0) {
+    setError(error, "invalid block size, sample rate or channel count");
+    return false;
+  }
+  options_ = options;
+
+  auto device = std::make_unique<Device>();
+  const ma_backend nullBackend[] = {ma_backend_null};
+  const bool useNull = options.backend == AudioDeviceOptions::Backend::Null;
+  ma_result result = ma_context_init(useNull ? nullBackend : nullptr,
+                                     useNull ? 1 : 0, nullptr,
+                                     &device->context);
+  if (result != MA_SUCCESS) {
+    setError(error, std::string("cannot initialize audio context: ") +
+                        ma_result_description(result));
+    return false;
+  }
+  device->hasContext = true;
+
+  const ma_device_type type =
+      options.numInputs > 0
+          ? (options.numOutputs > 0 ? ma_device_type_duplex
+                                    : ma_device_type_capture)
+          : ma_device_type_playback;
+  ma_device_config config = ma_device_config_init(type);
+  config.sampleRate = static_cast<ma_uint32>(std::lround(options.sampleRate));
+  config.periodSizeInFrames = static_cast<ma_uint32>(
+      options.periodFrames > 0 ? options.periodFrames : options.blockSize);
+  config.playback.format = ma_format_f32;
+  config.playback.channels = static_cast<ma_uint32>(options.numOutputs);
+  config.capture.format = ma_format_f32;
+  config.capture.channels = static_cast<ma_uint32>(options.numInputs);
+  // BlockAdapter re-blocks without the extra copy of miniaudio's fixed-size
+  // mode unless asked for it, and writes every output frame.
+  config.noFixedSizedCallback = options.fixedPeriod ? MA_FALSE : MA_TRUE;
+  config.noPreSilencedOutputBuffer = MA_TRUE;
+  config.dataCallback = [](ma_device *pDevice, void *pOutput,
+                           const void *pInput, ma_uint32 frameCount) {
+    static_cast<AudioDevice *>(pDevice->pUserData)
+        ->onCallback(pOutput, pInput, frameCount);
+  };
+  config.pUserData = this;
+
+  result = ma_device_init(&device->context, &config, &device->device);
+  if (result != MA_SUCCESS) {
+    setError(error, std::string("cannot open audio device: ") +
+                        ma_result_description(result));
+    return false;
+  }
+  device->hasDevice = true;
+  sampleRate_ = static_cast<double>(device->device.sampleRate);
+
+  CompileOptions compileOptions;
+  compileOptions.sampleRate = sampleRate_;
+  compileOptions.blockSize = options.blockSize;
+  compileOptions.numThreads = std::max(1, options.numThreads);
+  compileOptions.numPhysicalInputs = options.numInputs;
+  if (!engine_.commit(graph, compileOptions, error)) {
+    sampleRate_ = 0.0;
+    return false;
+  }
+
+  const ma_device &d = device->device;
+  const uint32_t maxCallbackFrames = std::max(
+      d.playback.internalPeriodSizeInFrames * d.playback.internalPeriods,
+      d.capture.internalPeriodSizeInFrames * d.capture.internalPeriods);
+  adapter_ = std::make_unique<BlockAdapter>(
+      engine_, options.blockSize, options.numInputs, options.numOutputs,
+      static_cast<int>(std::max<uint32_t>(maxCallbackFrames,
+                                          config.periodSizeInFrames)),
+      config.noFixedSizedCallback
+          ? 0
+          : static_cast<int>(config.periodSizeInFrames));
+  callbacks_.store(0, std::memory_order_relaxed);
+  frames_.store(0, std::memory_order_relaxed);
+  device_ = std::move(device);
+  return true;
+}
+
+bool AudioDevice::start(std::string *error) {
+  if (!device_) {
+    setError(error, "device is not open");
+    return false;
+  }
+  const ma_result result = ma_device_start(&device_->device);
+  if (result != MA_SUCCESS) {
+    setError(error, std::string("cannot start audio device: ") +
+                        ma_result_description(result));
+    return false;
+  }
+  return true;
+}
+
+bool AudioDevice::stop(std::string *error) {
+  if (!device_ || !ma_device_is_started(&device_->device)) {
+    return true;
+  }
+  const ma_result result = ma_device_stop(&device_->device);
+  if (result != MA_SUCCESS) {
+    setError(error, std::string("cannot stop audio device: ") +
+                        ma_result_description(result));
+    return false;
+  }
+  return true;
+}
+
+void AudioDevice::close() {
+  // Uninitializing the device stops it and waits for the callback thread.
+  device_.reset();
+  adapter_.reset();
+  engine_.clear();
+  sampleRate_ = 0.0;
+}
+
+void AudioDevice::onCallback(void *output, const void *input,
+                             uint32_t numFrames) {
+  adapter_->process(static_cast<const float *>(input),
+                    static_cast<float *>(output),
+                    static_cast<int>(numFrames));
+  callbacks_.fetch_add(1, std::memory_order_relaxed);
+  frames_.fetch_add(numFrames, std::memory_order_relaxed);
+}
+
+} // namespace ms
@@ -0,0 +1,134 @@
+#include "io/BlockAdapter.hpp"
+#include "dsp/Kernels.hpp"
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace ms {
+
+BlockAdapter::BlockAdapter(GraphEngine &engine, int blockSize, int numInputs,
+                           int numOutputs, int maxCallbackFrames,
+                           int fixedCallbackFrames)
+    : engine_(engine), blockSize_(std::max(1, blockSize)),
+      numInputs_(std::max(0, numInputs)),
+      numOutputs_(std::max(0, numOutputs)) {
+  maxChunk_ = std::max(1, maxCallbackFrames);
+  if (numInputs_ > 0 && numOutputs_ > 0) {
+    latency_ = fixedCallbackFrames > 0
+                   ? blockSize_ - std::gcd(fixedCallbackFrames, blockSize_)
+                   : blockSize_ - 1;
+    if (fixedCallbackFrames > maxChunk_) {
+      // Split callbacks are no longer of the fixed size.
+      latency_ = blockSize_ - 1;
+    }
+  }
+
+  // Before a chunk arrives at most blockSize - 1 frames are pending, since
+  // latency_ < blockSize and capture-only devices run blocks eagerly.
+  const int needed = blockSize_ - 1 + maxChunk_;
+  capacity_ = (needed + blockSize_ - 1) / blockSize_ * blockSize_;
+  if (numInputs_ > 0) {
+    ring_ = std::make_unique<BufferPool>(numInputs_, capacity_);
+    for (int c = 0; c < numInputs_; ++c) {
+      std::memset(ring_->getBuffer(c), 0, sizeof(float) * capacity_);
+    }
+  }
+  available_ = latency_;
+  silence_.assign(blockSize_, 0.0f);
+  inputChannels_.assign(numInputs_, nullptr);
+  physicalInputs_.assign(numInputs_, nullptr);
+  outputChannels_.assign(numOutputs_, nullptr);
+}
+
+void BlockAdapter::process(const float *input, float *output,
+                           int numFrames) {
+  while (numFrames > 0) {
+    const int frames = std::min(numFrames, maxChunk_);
+    if (numInputs_ > 0) {
+      writeInput(input, frames);
+    }
+    if (output && numOutputs_ > 0) {
+      writeOutput(output, frames);
+      output += static_cast<size_t>(frames) * numOutputs_;
+    } else {
+      while (available_ >= blockSize_ && runBlock()) {
+      }
+    }
+    if (input) {
+      input += static_cast<size_t>(frames) * numInputs_;
+    }
+    numFrames -= frames;
+  }
+}
+
+void BlockAdapter::writeInput(const float *input, int numFrames) {
+  const dsp::Kernels &k = dsp::kernels();
+  int written = 0;
+  while (written < numFrames) {
+    const int position = (readPosition_ + available_) % capacity_;
+    const int span = std::min(numFrames - written, capacity_ - position);
+    for (int c = 0; c < numInputs_; ++c) {
+      inputChannels_[c] = ring_->getBuffer(c) + position;
+    }
+    if (input) {
+      k.deinterleave(inputChannels_.data(),
+                     input + static_cast<size_t>(written) * numInputs_,
+                     numInputs_, span);
+    } else {
+      for (int c = 0; c < numInputs_; ++c) {
+        k.fillLinear(inputChannels_[c], span, 0.0f, 0.0f);
+      }
+    }
+    available_ += span;
+    written += span;
+  }
+}
+
+void BlockAdapter::writeOutput(float *output, int numFrames) {
+  const dsp::Kernels &k = dsp::kernels();
+  int written = 0;
+  while (written < numFrames) {
+    if (blockRemaining_ == 0 && !runBlock()) {
+      std::memset(output + static_cast<size_t>(written) * numOutputs_, 0,
+                  sizeof(float) * (numFrames - written) * numOutputs_);
+      underruns_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    const int frames = std::min(numFrames - written, blockRemaining_);
+    const int offset = blockSize_ - blockRemaining_;
+    const ExecutionPlan *plan = engine_.getCurrentPlan();
+    const int available = plan && plan->getBlockSize() == blockSize_
+                              ? plan->getNumOutputs()
+                              : 0;
+    for (int c = 0; c < numOutputs_; ++c) {
+      outputChannels_[c] = c < available ? plan->getOutputBuffer(c) + offset
+                                         : silence_.data();
+    }
+    k.interleave(output + static_cast<size_t>(written) * numOutputs_,
+                 outputChannels_.data(), numOutputs_, frames);
+    blockRemaining_ -= frames;
+    written += frames;
+  }
+}
+
+bool BlockAdapter::runBlock() {
+  if (numInputs_ > 0) {
+    if (available_ < blockSize_) {
+      return false;
+    }
+    for (int c = 0; c < numInputs_; ++c) {
+      physicalInputs_[c] = ring_->getBuffer(c) + readPosition_;
+    }
+    readPosition_ = (readPosition_ + blockSize_) % capacity_;
+    available_ -= blockSize_;
+  }
+  if (!engine_.process(physicalInputs_.data(), numInputs_, blockSize_) &&
+      engine_.getCurrentPlan()) {
+    // The plan has another block size; its block is output as silence.
+    underruns_.fetch_add(1, std::memory_order_relaxed);
+  }
+  blockRemaining_ = blockSize_;
+  return true;
+}
+
+} // namespace ms
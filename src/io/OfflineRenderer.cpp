@@ -0,0 +1,262 @@
+#include "io/OfflineRenderer.hpp"
+#include "../core/Error.hpp"
+#include "dsp/Kernels.hpp"
+#include "miniaudio.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+namespace ms {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+ma_format toMaFormat(OfflineRenderOptions::SampleFormat format) {
+  switch (format) {
+  case OfflineRenderOptions::SampleFormat::Int16:
+    return ma_format_s16;
+  case OfflineRenderOptions::SampleFormat::Int24:
+    return ma_format_s24;
+  case OfflineRenderOptions::SampleFormat::Int32:
+    return ma_format_s32;
+  default:
+    return ma_format_f32;
+  }
+}
+
+/** Nonzero start value of the dither generator. */
+constexpr uint32_t kDitherSeed = 0x9e3779b9u;
+
+/** Advances a xorshift generator; returns a uniform value in [0, 1). */
+float nextUniform(uint32_t &state) {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return static_cast<float>(state >> 8) * (1.0f / 16777216.0f);
+}
+
+double secondsSince(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+} // namespace
+
+struct OfflineRenderer::Writer {
+  ma_format format = ma_format_f32;
+  bool isWav = true;
+  ma_encoder encoder;
+  FILE *raw = nullptr;
+};
+
+OfflineRenderer::OfflineRenderer(const OfflineRenderOptions &options)
+    : options_(options) {}
+
+OfflineRenderer::~OfflineRenderer() { close(); }
+
+bool OfflineRenderer::open(const Graph &graph, const std::string &path,
+                           std::string *error) {
+  if (!close(error)) {
+    return false;
+  }
+  if (options_.sampleRate <= 0.0 || options_.blockSize <= 0 ||
+      options_.chunkFrames <= 0) {
+    setError(error, "invalid sample rate, block size or chunk size");
+    return false;
+  }
+  if (graph.getOutputs().empty()) {
+    setError(error, "graph has no outputs");
+    return false;
+  }
+
+  CompileOptions compileOptions;
+  compileOptions.sampleRate = options_.sampleRate;
+  compileOptions.blockSize = options_.blockSize;
+  compileOptions.numThreads = std::max(1, options_.numThreads);
+  if (!engine_.commit(graph, compileOptions, error)) {
+    return false;
+  }
+
+  auto writer = std::make_unique<Writer>();
+  writer->format = toMaFormat(options_.sampleFormat);
+  writer->isWav = options_.fileFormat == OfflineRenderOptions::FileFormat::Wav;
+  numChannels_ = static_cast<int>(graph.getOutputs().size());
+  if (writer->isWav) {
+    const ma_encoder_config config = ma_encoder_config_init(
+        ma_encoding_format_wav, writer->format,
+        static_cast<ma_uint32>(numChannels_),
+        static_cast<ma_uint32>(std::lround(options_.sampleRate)));
+    const ma_result result =
+        ma_encoder_init_file(path.c_str(), &config, &writer->encoder);
+    if (result != MA_SUCCESS) {
+      setError(error, "cannot create '" + path +
+                          "': " + ma_result_description(result));
+      engine_.clear();
+      return false;
+    }
+  } else {
+    writer->raw = std::fopen(path.c_str(), "wb");
+    if (!writer->raw) {
+      setError(error, "cannot create '" + path + "'");
+      engine_.clear();
+      return false;
+    }
+  }
+  writer_ = std::move(writer);
+
+  const size_t samples =
+      static_cast<size_t>(options_.chunkFrames) * numChannels_;
+  chunk_.assign(samples, 0.0f);
+  encoded_.assign(samples * ma_get_bytes_per_sample(writer_->format), 0);
+  channels_.assign(numChannels_, nullptr);
+  silence_.assign(options_.blockSize, 0.0f);
+  chunkFill_ = 0;
+  blockRemaining_ = 0;
+  ditherState_ = kDitherSeed;
+  stats_ = OfflineRenderStats();
+  return true;
+}
+
+bool OfflineRenderer::render(uint64_t numFrames, std::string *error) {
+  if (!writer_) {
+    setError(error, "no file is open");
+    return false;
+  }
+  const Clock::time_point start = Clock::now();
+  const int blockSize = options_.blockSize;
+  bool ok = true;
+
+  while (numFrames > 0 && ok) {
+    if (blockRemaining_ == 0) {
+      const Clock::time_point blockStart = Clock::now();
+      // A plan with another block size is picked up but never run.
+      if (!engine_.process(nullptr, 0, blockSize)) {
+        setError(error,
+                 "the engine's plan does not use the render block size");
+        ok = false;
+        break;
+      }
+      stats_.processSeconds += secondsSince(blockStart);
+      blockRemaining_ = blockSize;
+    }
+
+    const int frames = static_cast<int>(
+        std::min<uint64_t>(numFrames, static_cast<uint64_t>(std::min(
+                                          blockRemaining_,
+                                          options_.chunkFrames - chunkFill_))));
+    const int offset = blockSize - blockRemaining_;
+    const ExecutionPlan *plan = engine_.getCurrentPlan();
+    const int available = std::min(numChannels_, plan->getNumOutputs());
+    for (int ch = 0; ch < numChannels_; ++ch) {
+      channels_[ch] = ch < available ? plan->getOutputBuffer(ch) + offset
+                                     : silence_.data();
+    }
+    dsp::kernels().interleave(
+        chunk_.data() + static_cast<size_t>(chunkFill_) * numChannels_,
+        channels_.data(), numChannels_, frames);
+
+    chunkFill_ += frames;
+    blockRemaining_ -= frames;
+    numFrames -= static_cast<uint64_t>(frames);
+    stats_.framesRendered += static_cast<uint64_t>(frames);
+    if (chunkFill_ == options_.chunkFrames) {
+      ok = flush(error);
+    }
+  }
+
+  stats_.audioSeconds =
+      static_cast<double>(stats_.framesRendered) / options_.sampleRate;
+  stats_.totalSeconds += secondsSince(start);
+  return ok;
+}
+
+bool OfflineRenderer::flush(std::string *error) {
+  if (chunkFill_ == 0) {
+    return true;
+  }
+  const void *data = chunk_.data();
+  if (writer_->format != ma_format_f32) {
+    // miniaudio's own dither draws from a process-wide generator, which
+    // would make the bytes depend on every other render in the process.
+    if (options_.dither == OfflineRenderOptions::Dither::Triangle) {
+      addDither();
+    }
+    ma_convert_pcm_frames_format(encoded_.data(), writer_->format,
+                                 chunk_.data(), ma_format_f32,
+                                 static_cast<ma_uint64>(chunkFill_),
+                                 static_cast<ma_uint32>(numChannels_),
+                                 ma_dither_mode_none);
+    data = encoded_.data();
+  }
+
+  bool ok;
+  if (writer_->isWav) {
+    ma_uint64 written = 0;
+    ok = ma_encoder_write_pcm_frames(&writer_->encoder, data,
+                                     static_cast<ma_uint64>(chunkFill_),
+                                     &written) == MA_SUCCESS &&
+         written == static_cast<ma_uint64>(chunkFill_);
+  } else {
+    const size_t frameBytes = static_cast<size_t>(numChannels_) *
+                              ma_get_bytes_per_sample(writer_->format);
+    ok = std::fwrite(data, frameBytes, static_cast<size_t>(chunkFill_),
+                     writer_->raw) == static_cast<size_t>(chunkFill_);
+  }
+  chunkFill_ = 0;
+  if (!ok) {
+    setError(error, "write failed");
+  }
+  return ok;
+}
+
+void OfflineRenderer::addDither() {
+  // The difference of two uniform values is triangular over [-1, 1] steps;
+  // it decorrelates the requantization error from the signal.
+  const float step =
+      1.0f / static_cast<float>(
+                 1u << (8 * ma_get_bytes_per_sample(writer_->format) - 1));
+  const size_t samples = static_cast<size_t>(chunkFill_) * numChannels_;
+  for (size_t i = 0; i < samples; ++i) {
+    chunk_[i] += (nextUniform(ditherState_) - nextUniform(ditherState_)) * step;
+  }
+}
+
+bool OfflineRenderer::close(std::string *error) {
+  if (!writer_) {
+    engine_.clear();
+    return true;
+  }
+  const Clock::time_point start = Clock::now();
+  bool ok = flush(error);
+  if (writer_->isWav) {
+    // Rewrites the header with the final length.
+    ma_encoder_uninit(&writer_->encoder);
+  } else if (std::fclose(writer_->raw) != 0 && ok) {
+    setError(error, "write failed");
+    ok = false;
+  }
+  writer_.reset();
+  engine_.clear();
+  stats_.totalSeconds += secondsSince(start);
+  return ok;
+}
+
+bool renderToFile(const Graph &graph, const std::string &path, double seconds,
+                  const OfflineRenderOptions &options,
+                  OfflineRenderStats *stats, std::string *error) {
+  OfflineRenderer renderer(options);
+  const bool ok =
+      renderer.open(graph, path, error) &&
+      renderer.render(static_cast<uint64_t>(
+                          std::llround(std::max(0.0, seconds) *
+                                       options.sampleRate)),
+                      error) &&
+      renderer.close(error);
+  if (stats) {
+    *stats = renderer.getStats();
+  }
+  return ok;
+}
+
+} // namespace ms
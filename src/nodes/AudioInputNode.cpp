@@ -0,0 +1,24 @@
+#include "nodes/AudioInputNode.hpp"
+#include "dsp/Kernels.hpp"
+
+namespace ms {
+
+AudioInputNode::AudioInputNode(const std::string &id, int channel, float gain)
+    : Node(id), channel_(channel) {
+  addOutputPort("out", PortType::Audio);
+  setParams({Param("gain", gain, Smoothing{Smoothing::Mode::Linear, 0.01f})});
+}
+
+void AudioInputNode::process(const ProcessContext &ctx) {
+  const dsp::Kernels &k = dsp::kernels();
+  const float *in = getPhysicalInput(channel_);
+  if (!in) {
+    k.fillLinear(ctx.outputs[0], ctx.numFrames, 0.0f, 0.0f);
+  } else if (const float *gains = getParamBuffer(kGain)) {
+    k.multiply(ctx.outputs[0], in, gains, ctx.numFrames);
+  } else {
+    k.scale(ctx.outputs[0], in, ctx.numFrames, getParamValue(kGain));
+  }
+}
+
+} // namespace ms
@@ -0,0 +1,97 @@
+#include "nodes/BiquadNode.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace ms {
+
+BiquadNode::BiquadNode(const std::string &id, Mode mode, float cutoff,
+                       float q)
+    : Node(id) {
+  addInputPort("in", PortType::Audio);
+  addOutputPort("out", PortType::Audio, 0);
+  setParams({
+      Param("cutoff", cutoff, Smoothing{Smoothing::Mode::Exponential, 0.02f}),
+      Param("q", q, Smoothing{Smoothing::Mode::Linear, 0.02f}),
+      Param("mode", static_cast<int>(mode)),
+  });
+}
+
+dsp::BiquadCoefficients BiquadNode::design(Mode mode, float cutoff, float q,
+                                           double sampleRate) {
+  const double frequency =
+      std::min(std::max(static_cast<double>(cutoff), 10.0), 0.49 * sampleRate);
+  const double w0 = 2.0 * 3.14159265358979323846 * frequency / sampleRate;
+  const double cosw0 = std::cos(w0);
+  const double alpha =
+      std::sin(w0) / (2.0 * std::max(static_cast<double>(q), 0.1));
+  const double a0 = 1.0 + alpha;
+
+  double b0, b1, b2;
+  switch (mode) {
+  case Mode::Highpass:
+    b0 = (1.0 + cosw0) * 0.5;
+    b1 = -(1.0 + cosw0);
+    b2 = b0;
+    break;
+  case Mode::Bandpass:
+    b0 = alpha;
+    b1 = 0.0;
+    b2 = -alpha;
+    break;
+  default:
+    b0 = (1.0 - cosw0) * 0.5;
+    b1 = 1.0 - cosw0;
+    b2 = b0;
+    break;
+  }
+
+  dsp::BiquadCoefficients c;
+  c.b0 = static_cast<float>(b0 / a0);
+  c.b1 = static_cast<float>(b1 / a0);
+  c.b2 = static_cast<float>(b2 / a0);
+  c.a1 = static_cast<float>(-2.0 * cosw0 / a0);
+  c.a2 = static_cast<float>((1.0 - alpha) / a0);
+  return c;
+}
+
+void BiquadNode::onPrepare(double sampleRate, int blockSize) {
+  (void)sampleRate;
+  (void)blockSize;
+  state_ = dsp::BiquadState();
+  designedCutoff_ = -1.0f;
+}
+
+void BiquadNode::updateCoefficients(Mode mode, float cutoff, float q) {
+  if (mode == designedMode_ && cutoff == designedCutoff_ && q == designedQ_) {
+    return;
+  }
+  coefficients_ = design(mode, cutoff, q, getSampleRate());
+  designedMode_ = mode;
+  designedCutoff_ = cutoff;
+  designedQ_ = q;
+}
+
+void BiquadNode::process(const ProcessContext &ctx) {
+  const dsp::Kernels &k = dsp::kernels();
+  const Mode mode = static_cast<Mode>(static_cast<int>(getParamValue(kMode)));
+  const float *cutoffs = getParamBuffer(kCutoff);
+  const float *qs = getParamBuffer(kQ);
+
+  if (!cutoffs && !qs) {
+    updateCoefficients(mode, getParamValue(kCutoff), getParamValue(kQ));
+    k.biquad(ctx.outputs[0], ctx.inputs[0], ctx.numFrames, coefficients_,
+             state_);
+    return;
+  }
+
+  for (int start = 0; start < ctx.numFrames; start += kModulationInterval) {
+    const int length = std::min(kModulationInterval, ctx.numFrames - start);
+    updateCoefficients(mode,
+                       cutoffs ? cutoffs[start] : getParamValue(kCutoff),
+                       qs ? qs[start] : getParamValue(kQ));
+    k.biquad(ctx.outputs[0] + start, ctx.inputs[0] + start, length,
+             coefficients_, state_);
+  }
+}
+
+} // namespace ms
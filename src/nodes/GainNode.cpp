@@ -0,0 +1,22 @@
+#include "nodes/GainNode.hpp"
+#include "dsp/Kernels.hpp"
+
+namespace ms {
+
+GainNode::GainNode(const std::string &id, float gain) : Node(id) {
+  addInputPort("in", PortType::Audio);
+  addOutputPort("out", PortType::Audio, 0);
+  setParams({Param("gain", gain, Smoothing{Smoothing::Mode::Linear, 0.01f})});
+}
+
+void GainNode::process(const ProcessContext &ctx) {
+  const dsp::Kernels &k = dsp::kernels();
+  if (const float *gains = getParamBuffer(kGain)) {
+    k.multiply(ctx.outputs[0], ctx.inputs[0], gains, ctx.numFrames);
+  } else {
+    k.scale(ctx.outputs[0], ctx.inputs[0], ctx.numFrames,
+            getParamValue(kGain));
+  }
+}
+
+} // namespace ms
@@ -0,0 +1,39 @@
+#include "nodes/MixerNode.hpp"
+#include "dsp/Kernels.hpp"
+#include <algorithm>
+
+namespace ms {
+
+MixerNode::MixerNode(const std::string &id, int numInputs) : Node(id) {
+  std::vector<Param> params;
+  for (int i = 0; i < std::max(1, numInputs); ++i) {
+    addInputPort("in" + std::to_string(i), PortType::Audio);
+    params.push_back(Param("gain" + std::to_string(i), 1.0f,
+                           Smoothing{Smoothing::Mode::Linear, 0.01f}));
+  }
+  addOutputPort("out", PortType::Audio, 0);
+  setParams(params);
+}
+
+void MixerNode::process(const ProcessContext &ctx) {
+  const dsp::Kernels &k = dsp::kernels();
+  float *out = ctx.outputs[0];
+
+  // The first input initializes the output, which may alias it.
+  if (const float *gains = getParamBuffer(0)) {
+    k.multiply(out, ctx.inputs[0], gains, ctx.numFrames);
+  } else {
+    k.scale(out, ctx.inputs[0], ctx.numFrames, getParamValue(0));
+  }
+
+  const size_t numInputs = getInputPorts().size();
+  for (size_t i = 1; i < numInputs; ++i) {
+    if (const float *gains = getParamBuffer(i)) {
+      k.accumulateMultiply(out, ctx.inputs[i], gains, ctx.numFrames);
+    } else if (const float gain = getParamValue(i); gain != 0.0f) {
+      k.accumulate(out, ctx.inputs[i], ctx.numFrames, gain);
+    }
+  }
+}
+
+} // namespace ms
@@ -0,0 +1,45 @@
+#include "nodes/OscillatorNode.hpp"
+
+namespace ms {
+
+OscillatorNode::OscillatorNode(const std::string &id, float frequency,
+                               dsp::Waveform waveform)
+    : Node(id) {
+  addOutputPort("out", PortType::Audio);
+  setParams({
+      Param("frequency", frequency,
+            Smoothing{Smoothing::Mode::Exponential, 0.02f}),
+      Param("waveform", static_cast<int>(waveform)),
+  });
+}
+
+void OscillatorNode::onPrepare(double sampleRate, int blockSize) {
+  (void)sampleRate;
+  phase_ = 0.0f;
+  increments_.assign(blockSize, 0.0f);
+}
+
+void OscillatorNode::process(const ProcessContext &ctx) {
+  const dsp::Kernels &k = dsp::kernels();
+  const float toIncrement = 1.0f / static_cast<float>(getSampleRate());
+  const dsp::Waveform waveform =
+      dsp::toWaveform(static_cast<int>(getParamValue(kWaveform)));
+  float *out = ctx.outputs[0];
+
+  if (const float *frequency = getParamBuffer(kFrequency)) {
+    float *increments = increments_.data();
+    k.scale(increments, frequency, ctx.numFrames, toIncrement);
+    for (int i = 0; i < ctx.numFrames; ++i) {
+      increments[i] = dsp::clampIncrement(increments[i]);
+    }
+    phase_ = k.oscillatorModulated(out, increments, ctx.numFrames, phase_,
+                                   waveform);
+    return;
+  }
+
+  const float increment =
+      dsp::clampIncrement(getParamValue(kFrequency) * toIncrement);
+  phase_ = k.oscillator(out, ctx.numFrames, phase_, increment, waveform);
+}
+
+} // namespace ms
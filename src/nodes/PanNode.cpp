@@ -0,0 +1,56 @@
+#include "nodes/PanNode.hpp"
+#include "dsp/Kernels.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace ms {
+
+namespace {
+
+/** theta in turns of a full circle: (pan + 1) / 8. */
+float panToTurns(float pan) {
+  return (std::min(std::max(pan, -1.0f), 1.0f) + 1.0f) * 0.125f;
+}
+
+} // namespace
+
+PanNode::PanNode(const std::string &id, float pan) : Node(id) {
+  addInputPort("in", PortType::Audio);
+  addOutputPort("left", PortType::Audio, 0);
+  addOutputPort("right", PortType::Audio);
+  setParams({Param("pan", pan, Smoothing{Smoothing::Mode::Linear, 0.02f})});
+}
+
+void PanNode::onPrepare(double sampleRate, int blockSize) {
+  (void)sampleRate;
+  leftGains_.assign(blockSize, 0.0f);
+  rightGains_.assign(blockSize, 0.0f);
+}
+
+void PanNode::process(const ProcessContext &ctx) {
+  const dsp::Kernels &k = dsp::kernels();
+  const float *in = ctx.inputs[0];
+  float *left = ctx.outputs[0];
+  float *right = ctx.outputs[1];
+
+  // right is written first: left may alias in.
+  if (const float *pan = getParamBuffer(kPan)) {
+    float *leftGains = leftGains_.data();
+    float *rightGains = rightGains_.data();
+    for (int i = 0; i < ctx.numFrames; ++i) {
+      rightGains[i] = panToTurns(pan[i]);
+      leftGains[i] = rightGains[i] + 0.25f;
+    }
+    k.sine(rightGains, rightGains, ctx.numFrames);
+    k.sine(leftGains, leftGains, ctx.numFrames);
+    k.multiply(right, in, rightGains, ctx.numFrames);
+    k.multiply(left, in, leftGains, ctx.numFrames);
+    return;
+  }
+
+  const float theta = panToTurns(getParamValue(kPan)) * 6.28318531f;
+  k.scale(right, in, ctx.numFrames, std::sin(theta));
+  k.scale(left, in, ctx.numFrames, std::cos(theta));
+}
+
+} // namespace ms
@@ -0,0 +1,261 @@
+#include "nodes/PolySynthNode.hpp"
+#include "nodes/BiquadNode.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace ms {
+
+namespace {
+
+/** The attack aims above full level so that it reaches 1 in finite time. */
+constexpr float kAttackTarget = 1.5f;
+
+/** ln(kAttackTarget / (kAttackTarget - 1)): log span of the attack. */
+constexpr float kAttackSpan = 1.0986123f;
+
+/** ln(1000): the log span of a 60 dB fall. */
+constexpr float kSixtyDecibels = 6.9077553f;
+
+/** Level below which a released voice is freed, -80 dB. */
+constexpr float kSilence = 1e-4f;
+
+/** One-pole rate covering a log span of the level in the given time. */
+float envelopeRate(float seconds, double sampleRate, float span) {
+  if (seconds <= 0.0f) {
+    return 1.0f;
+  }
+  return static_cast<float>(
+      1.0 - std::exp(-span / (static_cast<double>(seconds) * sampleRate)));
+}
+
+/** Number of float arrays of the VoiceBank with one entry per voice. */
+constexpr size_t kNumVoiceArrays = 16;
+
+} // namespace
+
+PolySynthNode::PolySynthNode(const std::string &id, int numVoices,
+                             VoicePool::Stealing stealing)
+    : Node(id), pool_(std::max(1, numVoices), stealing) {
+  addOutputPort("left", PortType::Audio);
+  addOutputPort("right", PortType::Audio);
+  setParams({
+      Param("waveform", static_cast<int>(dsp::Waveform::Saw)),
+      Param("cutoff", 2000.0f),
+      Param("q", 0.7071f),
+      Param("keytrack", 0.5f),
+      Param("attack", 0.005f),
+      Param("decay", 0.3f),
+      Param("sustain", 0.7f),
+      Param("release", 0.3f),
+      Param("gain", 0.25f),
+      Param("spread", 0.0f),
+  });
+}
+
+void PolySynthNode::onPrepare(double sampleRate, int blockSize) {
+  const int numVoices = pool_.getNumVoices();
+  numLanes_ = (numVoices + dsp::kVoiceLanes - 1) / dsp::kVoiceLanes *
+              dsp::kVoiceLanes;
+  const size_t lanes = static_cast<size_t>(numLanes_);
+  const size_t mix = static_cast<size_t>(blockSize) * dsp::kVoiceLanes;
+  storage_.assign(kNumVoiceArrays * lanes + 2 * mix, 0.0f);
+
+  float *next = storage_.data();
+  float **arrays[kNumVoiceArrays] = {
+      &bank_.phase,  &bank_.increment, &bank_.b0,       &bank_.b1,
+      &bank_.b2,     &bank_.a1,        &bank_.a2,       &bank_.x1,
+      &bank_.x2,     &bank_.y1,        &bank_.y2,       &bank_.level,
+      &bank_.target, &bank_.rate,      &bank_.gainLeft, &bank_.gainRight};
+  for (float **array : arrays) {
+    *array = next;
+    next += lanes;
+  }
+  bank_.mixLeft = next;
+  bank_.mixRight = next + mix;
+
+  const float idleIncrement = static_cast<float>(440.0 / sampleRate);
+  for (int v = 0; v < numLanes_; ++v) {
+    bank_.increment[v] = idleIncrement;
+    bank_.b0[v] = 1.0f;
+    resetVoice(v);
+  }
+  velocities_.assign(lanes, 0.0f);
+  groups_.assign(lanes / dsp::kVoiceLanes, 0);
+  numGroups_ = 0;
+  pool_.clear();
+  designedCutoff_ = -1.0f;
+  appliedGain_ = -1.0f;
+}
+
+void PolySynthNode::resetVoice(int voice) {
+  bank_.level[voice] = 0.0f;
+  bank_.target[voice] = 0.0f;
+  bank_.rate[voice] = 0.0f;
+  bank_.gainLeft[voice] = 0.0f;
+  bank_.gainRight[voice] = 0.0f;
+}
+
+void PolySynthNode::startVoice(int voice, int note, float velocity) {
+  if (bank_.level[voice] == 0.0f) {
+    bank_.phase[voice] = 0.0f;
+    bank_.x1[voice] = 0.0f;
+    bank_.x2[voice] = 0.0f;
+    bank_.y1[voice] = 0.0f;
+    bank_.y2[voice] = 0.0f;
+  }
+  const double frequency = 440.0 * std::pow(2.0, (note - 69) / 12.0);
+  bank_.increment[voice] =
+      dsp::clampIncrement(static_cast<float>(frequency / getSampleRate()));
+  velocities_[voice] = velocity;
+  designFilter(voice);
+  updateGains(voice);
+  bank_.target[voice] = kAttackTarget;
+  bank_.rate[voice] = attackRate_;
+}
+
+void PolySynthNode::designFilter(int voice) {
+  const float octaves =
+      designedKeyTrack_ * static_cast<float>(pool_.getNote(voice) - 60) /
+      12.0f;
+  const dsp::BiquadCoefficients c =
+      BiquadNode::design(BiquadNode::Mode::Lowpass,
+                         designedCutoff_ * std::exp2(octaves), designedQ_,
+                         getSampleRate());
+  bank_.b0[voice] = c.b0;
+  bank_.b1[voice] = c.b1;
+  bank_.b2[voice] = c.b2;
+  bank_.a1[voice] = c.a1;
+  bank_.a2[voice] = c.a2;
+}
+
+void PolySynthNode::updateGains(int voice) {
+  const float pan = std::min(
+      std::max(appliedSpread_ *
+                   static_cast<float>(pool_.getNote(voice) - 60) / 24.0f,
+               -1.0f),
+      1.0f);
+  const float theta = (pan + 1.0f) * 0.785398163f;
+  const float gain = appliedGain_ * velocities_[voice];
+  bank_.gainLeft[voice] = gain * std::cos(theta);
+  bank_.gainRight[voice] = gain * std::sin(theta);
+}
+
+void PolySynthNode::updateGroups() {
+  numGroups_ = 0;
+  const int numVoices = pool_.getNumVoices();
+  for (int g = 0; g * dsp::kVoiceLanes < numVoices; ++g) {
+    const int end = std::min((g + 1) * dsp::kVoiceLanes, numVoices);
+    for (int v = g * dsp::kVoiceLanes; v < end; ++v) {
+      if (pool_.isActive(v)) {
+        groups_[numGroups_++] = g;
+        break;
+      }
+    }
+  }
+}
+
+void PolySynthNode::applyParams() {
+  const double sampleRate = getSampleRate();
+  bank_.waveform =
+      dsp::toWaveform(static_cast<int>(getParamValue(kWaveform)));
+  attackRate_ = envelopeRate(getParamValue(kAttack), sampleRate, kAttackSpan);
+  releaseRate_ =
+      envelopeRate(getParamValue(kRelease), sampleRate, kSixtyDecibels);
+  bank_.decayRate =
+      envelopeRate(getParamValue(kDecay), sampleRate, kSixtyDecibels);
+
+  const float sustain =
+      std::min(std::max(getParamValue(kSustain), 0.0f), 1.0f);
+  const float cutoff = getParamValue(kCutoff);
+  const float q = getParamValue(kQ);
+  const float keyTrack = getParamValue(kKeyTrack);
+  const float gain = getParamValue(kGain);
+  const float spread = getParamValue(kSpread);
+  const bool sustainChanged = sustain != bank_.sustain;
+  const bool filterChanged = cutoff != designedCutoff_ || q != designedQ_ ||
+                             keyTrack != designedKeyTrack_;
+  const bool gainChanged = gain != appliedGain_ || spread != appliedSpread_;
+  bank_.sustain = sustain;
+  designedCutoff_ = cutoff;
+  designedQ_ = q;
+  designedKeyTrack_ = keyTrack;
+  appliedGain_ = gain;
+  appliedSpread_ = spread;
+  if (!sustainChanged && !filterChanged && !gainChanged) {
+    return;
+  }
+
+  for (int v = 0; v < pool_.getNumVoices(); ++v) {
+    if (!pool_.isActive(v)) {
+      continue;
+    }
+    // Held voices past their attack move to the new sustain level.
+    if (sustainChanged && pool_.isHeld(v) && bank_.target[v] <= 1.0f) {
+      bank_.target[v] = sustain;
+      bank_.rate[v] = bank_.decayRate;
+    }
+    if (filterChanged) {
+      designFilter(v);
+    }
+    if (gainChanged) {
+      updateGains(v);
+    }
+  }
+}
+
+void PolySynthNode::freeSilentVoices() {
+  bool freed = false;
+  for (int g = 0; g < numGroups_; ++g) {
+    const int first = groups_[g] * dsp::kVoiceLanes;
+    const int end = std::min(first + dsp::kVoiceLanes, pool_.getNumVoices());
+    for (int v = first; v < end; ++v) {
+      if (pool_.isActive(v) && !pool_.isHeld(v) &&
+          bank_.level[v] < kSilence) {
+        pool_.free(v);
+        resetVoice(v);
+        freed = true;
+      }
+    }
+  }
+  if (freed) {
+    updateGroups();
+  }
+}
+
+void PolySynthNode::onEvent(const RtEvent &event) {
+  if (event.type != EventTypes::NoteOn && event.type != EventTypes::NoteOff) {
+    return;
+  }
+  const int note = event.value.asInt();
+  // A note_on with velocity 0 falls through to the note_off path.
+  if (event.type == EventTypes::NoteOn && event.data > 0.0f) {
+    const int voice = pool_.noteOn(note, bank_.level);
+    if (voice >= 0) {
+      startVoice(voice, note, std::min(event.data, 1.0f));
+      updateGroups();
+    }
+    return;
+  }
+  const int voice = pool_.noteOff(note);
+  if (voice >= 0) {
+    bank_.target[voice] = 0.0f;
+    bank_.rate[voice] = releaseRate_;
+  }
+}
+
+void PolySynthNode::process(const ProcessContext &ctx) {
+  const dsp::Kernels &k = dsp::kernels();
+  float *left = ctx.outputs[0];
+  float *right = ctx.outputs[1];
+  std::fill(left, left + ctx.numFrames, 0.0f);
+  std::fill(right, right + ctx.numFrames, 0.0f);
+  applyParams();
+
+  renderSegments(ctx, [&](int start, int end) {
+    k.voices(left + start, right + start, end - start, bank_, groups_.data(),
+             numGroups_);
+  });
+  freeSilentVoices();
+}
+
+} // namespace ms